@@ -0,0 +1,32 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+// Timing helpers shared by the micro-benchmarks
+namespace bench {
+
+// The fastest of `runs` runs of `process`, in nanoseconds for each of the `iterations` it loops over
+template<typename Process>
+double measure(int runs, int iterations, Process process)
+{
+	double best = 1e30;
+	for (int run = 0; run < runs; ++run)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		process();
+		const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		best = std::min(best, seconds);
+	}
+
+	return best / iterations * 1e9;
+}
+
+// Uses a result the timed loops accumulated into, so that the compiler can't discard them
+inline void sink(float value)
+{
+	if (value == 12345.f)
+		std::printf("\n");
+}
+
+}
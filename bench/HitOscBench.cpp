@@ -0,0 +1,127 @@
+// Per-sample cost of Hit's oscillator, against the sub-step it had before its filter damping and waveform blend
+// weights were precomputed: that one derived the blend from the wave type through nested selects and recomputed the
+// damping on every sub-step. Both render the same four voices, whose outputs must match exactly.
+// Built and run by `make bench`.
+#include "DaHit.cpp"
+#include "Bench.hpp"
+#include <cstdio>
+
+Plugin* pluginInstance;
+
+namespace da = DigitalAtavism;
+
+using Osc = da::Hit::Osc;
+
+// Osc::process() as it was, on the same state
+struct ReferenceOsc : Osc
+{
+	template<int supersampling>
+	simd::float_4 process(simd::float_4 wave_type, simd::float_4 square_duty, int lanes, da::Hit::Noise& noise)
+	{
+		simd::float_4 ret = 0.f;
+
+		fperiod *= fslide;
+
+		simd::int32_4 period = fperiod;
+		const auto tooShort = period < simd::int32_4(supersampling);
+		const auto tooLong = period > simd::int32_4(50000 * supersampling);
+		period = simd::ifelse(tooShort, simd::int32_4(supersampling), simd::ifelse(tooLong, simd::int32_4(50000 * supersampling), period));
+		const auto clamped = simd::float_4::cast(tooShort | tooLong);
+		fperiod = simd::ifelse(clamped, simd::float_4(period), fperiod);
+		fslide = simd::ifelse(clamped, simd::float_4(1.0f), fslide);
+
+		if (simd::movemask(phase >= period))
+			for (int i = 0; i < 4; ++i)
+				phase[i] %= period[i];
+
+		const simd::float_4 speriod = period;
+		const simd::int32_4 duty = square_duty * speriod;
+
+		for (int i = 0; i < supersampling; ++i)
+		{
+			phase += 1;
+			phase = simd::ifelse(phase >= period, simd::int32_4::zero(), phase);
+
+			const auto fp = simd::float_4(phase) / speriod;
+			const auto square = simd::ifelse(simd::float_4::cast(phase <= duty), simd::float_4(0.5f), simd::float_4(-0.5f));
+			const auto sawtooth = 1.0f - fp * 2;
+
+			const auto previous_noise_buffer_index = noise_buffer_index;
+			noise_buffer_index = simd::float_4(phase << 5) / speriod;
+			if (const auto changed = simd::movemask(simd::float_4::cast(noise_buffer_index != previous_noise_buffer_index)) & ((1 << lanes) - 1))
+				for (int j = 0; j < 4; ++j)
+					if (changed & (1 << j))
+						noise_value[j] = noise.next();
+
+			const auto noise = noise_value;
+			const auto sample = simd::ifelse(wave_type <= 1.0f,
+				(1.0f - wave_type) * square + sawtooth * wave_type,
+				simd::ifelse(wave_type <= 2.0f, (2.0f - wave_type) * sawtooth + noise * (wave_type - 1.0f),
+				(3.0f - wave_type) * noise + square * (wave_type - 2.0f)));
+
+			const auto pp = fltp;
+			fltdp += (sample - fltp) * fltw;
+			const auto fltdmp = 5.0f / (1.0f + da::math::sqr(0.4f * fltw) * 20.0f) * (0.04f + fltw);
+			fltdp -= fltdp * fltdmp;
+			fltp += fltdp;
+
+			fltphp += fltp - pp;
+			fltphp -= fltphp * flthp;
+
+			ret += fltphp;
+		}
+
+		return ret / supersampling;
+	}
+};
+
+enum { supersampling = 8, samples = 2000000, runs = 5 };
+
+// one wave type per lane, covering the three crossfades
+static const simd::float_4 waveType(0.5f, 1.f, 1.5f, 2.5f);
+static const simd::float_4 squareDuty(0.5f);
+
+template<typename T>
+static void setUp(T& osc)
+{
+	const auto mask = simd::float_4::mask();
+	osc.setOscPeriod(mask, 44100.f, simd::float_4(supersampling / 220.f, supersampling / 330.f, supersampling / 440.f, supersampling / 550.f));
+	osc.setLoPassFilter(mask, 0.6f);
+	osc.setHiPassFilter(mask, 0.1f);
+	osc.setWaveType(waveType);
+}
+
+int main()
+{
+	da::math::Random referenceRandom(1), random(1);
+	da::Hit::Noise referenceNoise(referenceRandom), noise(random);
+
+	ReferenceOsc reference;
+	Osc osc;
+	setUp(reference);
+	setUp(osc);
+
+	int mismatches = 0;
+	for (int n = 0; n < 100000; ++n)
+	{
+		const auto expected = reference.process<supersampling>(waveType, squareDuty, 4, referenceNoise);
+		const auto actual = osc.process<supersampling>(squareDuty, 4, noise);
+		mismatches += simd::movemask(expected != actual) != 0;
+	}
+
+	simd::float_4 sink = 0.f;
+	const auto before = bench::measure(runs, samples, [&]() {
+		for (int n = 0; n < samples; ++n)
+			sink += reference.process<supersampling>(waveType, squareDuty, 4, referenceNoise);
+	});
+	const auto after = bench::measure(runs, samples, [&]() {
+		for (int n = 0; n < samples; ++n)
+			sink += osc.process<supersampling>(squareDuty, 4, noise);
+	});
+
+	std::printf("Hit::Osc, 4 voices, %dx supersampling: before %.1f ns/sample, after %.1f ns/sample (%s)\n",
+		static_cast<int>(supersampling), before, after, mismatches ? "outputs differ" : "outputs match");
+	bench::sink(sink[0]);
+
+	return mismatches ? 1 : 0;
+}
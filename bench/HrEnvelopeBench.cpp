@@ -0,0 +1,140 @@
+// Per-frame cost of 16 hold-release envelopes in dsp::HrEnvelopeBank, against the scalar envelope the sfxr voices
+// ran one per channel before: it divided the samples left in its stage by the stage's length every sample, and
+// looped over the stages with a switch. The levels of both must agree to within rounding.
+// Built and run by `make bench`.
+#include "DA.hpp"
+#include "Bench.hpp"
+#include <cmath>
+#include <cstdio>
+
+Plugin* pluginInstance;
+
+namespace da = DigitalAtavism;
+
+// the scalar envelope as it was
+struct ReferenceEnvelope
+{
+	enum
+	{
+		STAGES_HOLD,
+		STAGES_RELEASE,
+		STAGES_COUNT,
+		STAGES_START = 0,
+	};
+
+	int env_time{};
+	int env_stage{ STAGES_COUNT };
+	int env_length[STAGES_COUNT] = {};
+	float punch{};
+
+	void start(float sampleRate, float holdTime, float releaseTime, float punchAmount = 0.0f)
+	{
+		env_time = 0;
+		env_stage = STAGES_START;
+		env_length[STAGES_HOLD] = static_cast<int>(holdTime * sampleRate);
+		env_length[STAGES_RELEASE] = static_cast<int>(releaseTime * sampleRate);
+		punch = punchAmount;
+	}
+
+	float process()
+	{
+		while (env_stage < STAGES_COUNT)
+		{
+			const auto& current_env_length = env_length[env_stage];
+			if (++env_time <= current_env_length)
+			{
+				const auto fraction = static_cast<float>(current_env_length - env_time) / current_env_length;
+				switch (env_stage)
+				{
+				case STAGES_HOLD:
+					return 1.0f + fraction * 2.0f * punch;
+				case STAGES_RELEASE:
+					return fraction;
+				default:
+					return 0;
+				}
+			}
+
+			env_time -= current_env_length;
+			++env_stage;
+		}
+
+		return 0;
+	}
+};
+
+enum { channels = 16, frames = 20000000, restartPeriod = 20000, runs = 3 };
+
+static const float sampleRate = 44100.f;
+
+// each channel gets its own hold time, so that the envelopes change stage on different frames
+static float holdTime(int channel)
+{
+	return 0.1f + channel * 0.01f;
+}
+
+static const float releaseTime = 0.3f;
+static const float punch = 0.4f;
+
+static void start(ReferenceEnvelope (&envelopes)[channels])
+{
+	for (int c = 0; c < channels; ++c)
+		envelopes[c].start(sampleRate, holdTime(c), releaseTime, punch);
+}
+
+static void start(da::dsp::HrEnvelopeBank<channels>& bank)
+{
+	for (int c = 0; c < channels; c += 4)
+		bank.start(c / 4, simd::float_4::mask(), sampleRate, simd::float_4(holdTime(c), holdTime(c + 1), holdTime(c + 2), holdTime(c + 3)), releaseTime, punch);
+}
+
+int main()
+{
+	ReferenceEnvelope reference[channels];
+	da::dsp::HrEnvelopeBank<channels> bank;
+
+	// over a whole envelope and past its end
+	start(reference);
+	start(bank);
+	float error = 0.f;
+	for (int n = 0; n < 30000; ++n)
+		for (int c = 0; c < channels; c += 4)
+		{
+			const auto levels = bank.process(c / 4);
+			for (int i = 0; i < 4; ++i)
+				error = std::max(error, std::fabs(levels[i] - reference[c + i].process()));
+		}
+
+	float sink = 0.f;
+	const auto before = bench::measure(runs, frames, [&]() {
+		float sum = 0.f;
+		for (int n = 0; n < frames; ++n)
+		{
+			if (n % restartPeriod == 0)
+				start(reference);
+
+			for (auto& envelope : reference)
+				sum += envelope.process();
+		}
+		sink += sum;
+	});
+	const auto after = bench::measure(runs, frames, [&]() {
+		simd::float_4 sum = 0.f;
+		for (int n = 0; n < frames; ++n)
+		{
+			if (n % restartPeriod == 0)
+				start(bank);
+
+			for (int v = 0; v < channels / 4; ++v)
+				sum += bank.process(v);
+		}
+		sink += sum[0];
+	});
+
+	const auto matches = error < 1e-5f;
+	std::printf("%d envelopes: scalar %.1f ns/frame, HrEnvelopeBank %.1f ns/frame (largest difference %g%s)\n",
+		static_cast<int>(channels), before, after, error, matches ? "" : ", too large");
+	bench::sink(sink);
+
+	return matches ? 0 : 1;
+}
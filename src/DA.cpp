@@ -12,17 +12,36 @@ float quantize(float value, unsigned bits)
 	{
 		return value >= 0.f ? 1.f : -1.f;
 	}
-	else if (bits > 64)
+	else if (bits >= 64)
 	{
 		return value;
 	}
+	else if (value >= 1.f)
+	{
+		return 1.f;
+	}
+	else if (value <= -1.f)
+	{
+		return -1.f;
+	}
 	else
 	{
-		const std::int64_t max = (1 << (bits - 1)) - 1;
+		const std::int64_t max = (std::int64_t(1) << (bits - 1)) - 1;
 		return static_cast<float>(static_cast<std::int64_t>(value * max)) / max;
 	}
 }
 
+QuantizeKernel getQuantizeKernel(unsigned bits)
+{
+	static const QuantizeKernel kernels[] = {
+		quantize<1>, quantize<2>, quantize<3>, quantize<4>, quantize<5>, quantize<6>, quantize<7>, quantize<8>,
+		quantize<9>, quantize<10>, quantize<11>, quantize<12>, quantize<13>, quantize<14>, quantize<15>, quantize<16>,
+		quantize<17>, quantize<18>, quantize<19>, quantize<20>, quantize<21>, quantize<22>, quantize<23>, quantize<24>
+	};
+
+	return kernels[std::min(std::max(bits, 1u), 24u) - 1];
+}
+
 namespace gui {
 
 void BaseModuleWidget::draw(const DrawArgs& args)
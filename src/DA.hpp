@@ -6,23 +6,144 @@ namespace math {
 template<typename T>
 static constexpr auto sqr(const T& v) -> decltype(v * v) { return v * v; }
 
+// xoshiro128+ (Blackman and Vigna): four words of state, a handful of instructions per draw.
+// Each module owns one, so audio threads never share generator state and a stored seed replays the same sequence.
+struct Random
+{
+	std::uint64_t seed{};
+	std::uint32_t state[4]{};
+
+	explicit Random(std::uint64_t seed = 0)
+	{
+		setSeed(seed);
+	}
+
+	void setSeed(std::uint64_t value)
+	{
+		seed = value;
+
+		// splitmix64 spreads any seed, including 0, over a non-zero state
+		for (int i = 0; i < 4; i += 2)
+		{
+			value += 0x9e3779b97f4a7c15ull;
+			auto z = value;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+			z ^= z >> 31;
+			state[i] = static_cast<std::uint32_t>(z);
+			state[i + 1] = static_cast<std::uint32_t>(z >> 32);
+		}
+	}
+
+	std::uint32_t next()
+	{
+		const auto result = state[0] + state[3];
+		const auto t = state[1] << 9;
+
+		state[2] ^= state[0];
+		state[3] ^= state[1];
+		state[1] ^= state[2];
+		state[0] ^= state[3];
+		state[2] ^= t;
+		state[3] = (state[3] << 11) | (state[3] >> 21);
+
+		return result;
+	}
+
+	// uniform in [0, n), using the high bits rather than a modulo
+	std::uint32_t next(std::uint32_t n)
+	{
+		return static_cast<std::uint32_t>((static_cast<std::uint64_t>(next()) * n) >> 32);
+	}
+
+	// fills buffer with frnd() values
+	void fill(float* buffer, int count)
+	{
+		for (int i = 0; i < count; ++i)
+			buffer[i] = next(10001) / 10000.f;
+	}
+};
+
+inline Random& threadRandom()
+{
+	static thread_local Random random{ rack::random::u64() };
+	return random;
+}
+
 template<unsigned N>
-inline unsigned rnd()
+inline unsigned rnd(Random& random = threadRandom())
+{
+	return random.next(N + 1);
+}
+
+inline float frnd(Random& random = threadRandom())
+{
+	return rnd<10000>(random) / 10000.f;
+}
+
+// 2^f for f in [0, 1): a degree-5 minimax polynomial pinned to p(0) = 1, so that whole octaves come out exact
+template<typename T>
+inline T exp2Fraction(T f)
+{
+	return ((((1.879318648e-3f * f + 8.990995096e-3f) * f + 5.581867596e-02f) * f + 2.401592715e-1f) * f + 6.931517388e-1f) * f + 1.f;
+}
+
+// 2^x with x clamped to [-126, 126], building 2^floor(x) in the exponent bits and the rest with exp2Fraction().
+// The relative error stays below 2e-7 (under 0.0004 cents as a V/oct pitch); integer x is exact.
+inline float fastExp2(float x)
+{
+	x = std::min(std::max(x, -126.f), 126.f);
+	const auto whole = std::floor(x);
+	const std::int32_t bits = (static_cast<std::int32_t>(whole) + 127) << 23;
+	float scale;
+	std::memcpy(&scale, &bits, sizeof(scale));
+	return exp2Fraction(x - whole) * scale;
+}
+
+inline simd::float_4 fastExp2(simd::float_4 x)
+{
+	x = simd::clamp(x, -126.f, 126.f);
+	const auto whole = simd::floor(x);
+	const auto scale = simd::float_4::cast((simd::int32_4(whole) + simd::int32_4(127)) << 23);
+	return exp2Fraction(x - whole) * scale;
+}
+
+// expands the low four bits of bits into a lane mask, bit i selecting lane i
+inline simd::float_4 laneMask(int bits)
+{
+	return simd::float_4::cast((simd::int32_4(bits) & simd::int32_4(1, 2, 4, 8)) != simd::int32_4::zero());
+}
+
+// a duration in whole samples, rounded to the nearest; any duration above zero lasts at least one sample. Timers count
+// these down rather than subtracting the sample time from a float, which drifts and lands a sample early or late.
+inline int toSamples(float duration, float sampleRate)
 {
-	return std::rand() % (N + 1);
+	return duration > 0.f ? std::max(static_cast<int>(duration * sampleRate + 0.5f), 1) : 0;
 }
 
-inline float frnd()
+inline simd::int32_4 toSamples(simd::float_4 duration, float sampleRate)
 {
-	return rnd<10000>() / 10000.f;
+	const auto samples = simd::int32_4(duration * sampleRate + 0.5f);
+	return simd::int32_4::cast(duration > 0.f) & simd::ifelse(samples < simd::int32_4(1), simd::int32_4(1), samples);
 }
 
 } // namespace math
 
 namespace dsp {
 
-struct HrEnvelope
+// N hold-release envelopes, stored structure-of-arrays and advanced four at a time. Each stage counts down the samples
+// it has left and scales them by a per-stage increment computed when it starts, so that process() needs no division.
+// Entering a stage also counts as its first step.
+template<int N>
+struct HrEnvelopeBank
 {
+	static_assert(N % 4 == 0, "envelopes come in vectors of four");
+
+	enum { VECTORS = N / 4 };
+
+	using T = simd::float_4;
+	using I = simd::int32_4;
+
 	enum
 	{
 		STAGES_HOLD,
@@ -31,84 +152,311 @@ struct HrEnvelope
 		STAGES_START = 0,
 	};
 
-	int env_time{};
-	int env_stage{ STAGES_COUNT };
-	int env_length[STAGES_COUNT] = {};
-	float punch{};
+	I env_stage[VECTORS];
+	// samples left in the current stage after the current one
+	I env_remaining[VECTORS];
+	I release_length[VECTORS];
+	// how far, in samples, the trigger that started each envelope came before the sample it started in
+	T env_elapsed[VECTORS];
+	// the envelope's change per sample in each stage; the hold stage's carries the punch
+	T env_increment[STAGES_COUNT][VECTORS];
+
+	HrEnvelopeBank()
+	{
+		for (int v = 0; v < VECTORS; ++v)
+		{
+			env_stage[v] = STAGES_COUNT;
+			env_remaining[v] = 0;
+			release_length[v] = 0;
+			env_elapsed[v] = 0.f;
+			for (auto& increment : env_increment)
+				increment[v] = 0.f;
+		}
+	}
 
-	void start(float sampleRate, float holdTime, float releaseTime, float punchAmount = 0.0f)
+	// starts the masked envelopes of vector v, elapsed samples into their hold stage
+	void start(int v, T mask, float sampleRate, T holdTime, T releaseTime, T punchAmount = 0.0f, T elapsed = 0.0f)
 	{
-		env_time = 0;
-		env_stage = STAGES_START;
-		env_length[STAGES_HOLD] = static_cast<int>(holdTime * sampleRate);
-		env_length[STAGES_RELEASE] = static_cast<int>(releaseTime * sampleRate);
-		punch = punchAmount;
+		const auto m = I::cast(mask);
+		const auto holdLength = I(holdTime * sampleRate);
+		const auto releaseLength = I(releaseTime * sampleRate);
+		env_stage[v] = simd::ifelse(m, I(STAGES_START), env_stage[v]);
+		env_remaining[v] = simd::ifelse(m, holdLength, env_remaining[v]);
+		release_length[v] = simd::ifelse(m, releaseLength, release_length[v]);
+		env_elapsed[v] = simd::ifelse(mask, elapsed, env_elapsed[v]);
+
+		// empty stages are skipped before their increment is ever used
+		env_increment[STAGES_HOLD][v] = simd::ifelse(mask, 2.0f * punchAmount / simd::fmax(T(holdLength), 1.f), env_increment[STAGES_HOLD][v]);
+		env_increment[STAGES_RELEASE][v] = simd::ifelse(mask, 1.0f / simd::fmax(T(releaseLength), 1.f), env_increment[STAGES_RELEASE][v]);
 	}
 
 	void stop()
 	{
-		env_stage = STAGES_COUNT;
+		for (auto& stage : env_stage)
+			stage = STAGES_COUNT;
+	}
+
+	void stop(int v, T mask)
+	{
+		env_stage[v] = simd::ifelse(I::cast(mask), I(STAGES_COUNT), env_stage[v]);
 	}
 
-	bool isActive() const { return env_stage < STAGES_COUNT; }
+	T isActive(int v) const { return T::cast(env_stage[v] < I(STAGES_COUNT)); }
 
-	float process(float deltaTime = 0.01f)
+	T process(int v)
 	{
-		while (env_stage < STAGES_COUNT)
-		{
-			const auto& current_env_length = env_length[env_stage];
-			if (++env_time <= current_env_length)
-			{
-				const auto fraction = static_cast<float>(current_env_length - env_time) / current_env_length;
-				switch (env_stage)
-				{
-				case STAGES_HOLD:
-					return 1.0f + fraction * 2.0f * punch;
-				case STAGES_RELEASE:
-					return fraction;
-				default:
-					return 0;
-				}
-			}
+		auto stage = env_stage[v];
+		auto remaining = env_remaining[v] - ((stage < I(STAGES_COUNT)) & I(1));
+
+		// a hold stage that ran out enters the release stage, and an empty release stage ends within the same sample
+		const auto released = (stage == I(STAGES_HOLD)) & (remaining < I::zero());
+		remaining += released & (release_length[v] - 1);
+		stage += released & I(1);
+		stage += (stage == I(STAGES_RELEASE)) & (remaining < I::zero()) & I(1);
+
+		env_stage[v] = stage;
+		env_remaining[v] = remaining;
+
+		const auto hold = T::cast(stage == I(STAGES_HOLD));
+		const auto increment = simd::ifelse(hold, env_increment[STAGES_HOLD][v], env_increment[STAGES_RELEASE][v]);
+		const auto env = simd::fmax(T(remaining) - env_elapsed[v], T::zero()) * increment + (hold & T(1.0f));
+		return T::cast(stage < I(STAGES_COUNT)) & env;
+	}
+};
 
-			env_time -= current_env_length;
-			++env_stage;
-		}
+// a Schmitt trigger that also estimates how long before the current sample the input crossed the high threshold of 1,
+// interpolating linearly between the previous and the current input
+template<typename T>
+struct TSubSampleTrigger
+{
+	rack::dsp::TSchmittTrigger<T> trigger;
+	T previous = 0.f;
+	// for the lanes triggered by the last process(), the time since the crossing in samples, within [0, 1]; 0 elsewhere
+	T elapsed = 0.f;
+
+	void reset()
+	{
+		trigger.reset();
+		previous = 0.f;
+		elapsed = 0.f;
+	}
+
+	T process(T in)
+	{
+		const auto triggered = trigger.process(in);
+		elapsed = T::zero();
+		if (simd::movemask(triggered))
+			elapsed = triggered & simd::clamp((in - 1.f) / simd::fmax(in - previous, 1e-6f), 0.f, 1.f);
+
+		previous = in;
+		return triggered;
+	}
+};
+
+// fires once, the given number of samples after it is triggered, counting the sample it was triggered in as the first;
+// a trigger while one is pending keeps the later of the two, and zero samples never fire
+template<typename T>
+struct TTickTrigger
+{
+	using I = simd::Vector<int32_t, T::size>;
+
+	I remaining = 0;
+
+	void reset()
+	{
+		remaining = 0;
+	}
+
+	void trigger(T mask, I samples)
+	{
+		remaining = simd::ifelse(I::cast(mask) & (samples > remaining), samples, remaining);
+	}
+
+	T process()
+	{
+		const auto active = remaining > I::zero();
+		remaining -= active & I(1);
+		return T::cast(active & (remaining == I::zero()));
+	}
+
+	T isActive() const
+	{
+		return T::cast(remaining > I::zero());
+	}
+};
+
+// high for the given number of samples, starting with the sample it is triggered in; a trigger while high keeps the longer
+template<typename T>
+struct TTickPulseGenerator
+{
+	using I = simd::Vector<int32_t, T::size>;
+
+	I remaining = 0;
+
+	void reset()
+	{
+		remaining = 0;
+	}
+
+	void trigger(T mask, I samples)
+	{
+		remaining = simd::ifelse(I::cast(mask) & (samples > remaining), samples, remaining);
+	}
+
+	void reset(T mask)
+	{
+		remaining = simd::ifelse(I::cast(mask), I::zero(), remaining);
+	}
+
+	T process()
+	{
+		const auto active = remaining > I::zero();
+		remaining -= active & I(1);
+		return T::cast(active);
+	}
+
+	T isActive() const
+	{
+		return T::cast(remaining > I::zero());
+	}
+};
+
+// times at which events fall due, kept in order in a fixed ring buffer; pushing is O(1) as long as events are pushed
+// in the order they fall due, and only walks back past the later ones otherwise
+template<typename Time, int capacity>
+struct EventQueue
+{
+	static_assert((capacity & (capacity - 1)) == 0, "capacity must be a power of 2");
+
+	Time due[capacity]{};
+	int head{};
+	int size{};
+
+	void reset()
+	{
+		head = 0;
+		size = 0;
+	}
+
+	bool empty() const { return size == 0; }
 
-		return 0;
+	Time front() const { return due[head]; }
+
+	void pop()
+	{
+		head = (head + 1) & (capacity - 1);
+		--size;
+	}
+
+	// returns false, dropping the event, when limit events are already pending
+	bool push(Time time, int limit = capacity)
+	{
+		if (size >= std::min(limit, static_cast<int>(capacity)))
+			return false;
+
+		auto i = size++;
+		for (; i > 0 && due[(head + i - 1) & (capacity - 1)] > time; --i)
+			due[(head + i) & (capacity - 1)] = due[(head + i - 1) & (capacity - 1)];
+
+		due[(head + i) & (capacity - 1)] = time;
+		return true;
 	}
 };
 
-struct TimedTrigger
+// sample-rate reduction by holding: takes a new value every period frames
+template<typename T>
+struct TRateReducer
 {
-	float remaining = 0.f;
-	bool state = true;
+	T value = 0.f;
+	int phase{};
 
 	void reset()
 	{
-		remaining = 0.f;
-		state = true;
+		value = 0.f;
+		phase = 0;
+	}
+
+	// steps one frame; returns true when the frame takes a new value
+	bool advance(int period)
+	{
+		const auto due = phase == 0;
+		if (++phase >= period)
+			phase = 0;
+
+		return due;
+	}
+};
+
+// windowed-sinc interpolation filter split into phases, for resampling by any ratio: phase p of phases interpolates
+// p / phases of the way from one input sample to the next, and the output lags the input by taps / 2 samples
+template<int taps, int phases>
+struct PolyphaseKernel
+{
+	static_assert(taps % 2 == 0, "the kernel is centred between two taps");
+
+	// each row runs from the oldest tap to the newest, matching TPolyphaseResampler's history
+	float coefficients[phases + 1][taps]{};
+
+	// cutoff is relative to the input's Nyquist frequency; below 1 it also band-limits the input for decimation
+	void design(float cutoff)
+	{
+		for (int p = 0; p <= phases; ++p)
+		{
+			auto sum = 0.f;
+			for (int i = 0; i < taps; ++i)
+			{
+				// distance of the tap from the interpolated point, in input samples
+				const auto d = (taps - 1 - i) - taps / 2 + static_cast<float>(p) / phases;
+				const auto x = static_cast<float>(M_PI) * cutoff * d;
+				const auto window = 0.42f + 0.5f * std::cos(static_cast<float>(M_PI) * d / (taps / 2)) + 0.08f * std::cos(static_cast<float>(2 * M_PI) * d / (taps / 2));
+				coefficients[p][i] = (x == 0.f ? 1.f : std::sin(x) / x) * window;
+				sum += coefficients[p][i];
+			}
+
+			// unity gain at DC for every phase
+			for (auto& coefficient : coefficients[p])
+				coefficient /= sum;
+		}
 	}
+};
 
-	bool process(float deltaTime)
+// the input history of a PolyphaseKernel, one channel per lane
+template<typename T, int taps>
+struct TPolyphaseResampler
+{
+	static_assert((taps & (taps - 1)) == 0, "taps must be a power of 2");
+
+	// stored twice over, so the last taps samples are always contiguous
+	T history[2 * taps]{};
+	int position{};
+	// consecutive all-zero samples pushed; once they fill the history the filter is skipped
+	int silent{ taps };
+
+	void reset()
 	{
-		const auto previousState = state;
-		if (isActive())
-			remaining -= deltaTime;
+		for (auto& sample : history)
+			sample = 0.f;
 
-		state = !isActive();
-		return !previousState && state;
+		position = 0;
+		silent = taps;
 	}
 
-	void trigger(float duration)
+	void push(T x)
 	{
-		if (duration > remaining)
-			remaining = duration;
+		history[position] = history[position + taps] = x;
+		position = (position + 1) & (taps - 1);
+		silent = simd::movemask(x != T::zero()) ? 0 : std::min(silent + 1, static_cast<int>(taps));
 	}
 
-	bool isActive() const
+	// the input interpolated with one row of the kernel
+	T process(const float* coefficients) const
 	{
-		return remaining > 0.f;
+		T y = 0.f;
+		if (silent < taps)
+			for (int i = 0; i < taps; ++i)
+				y += history[position + i] * coefficients[i];
+
+		return y;
 	}
 };
 
@@ -213,7 +561,7 @@ float quantize(float value)
 	{
 		return value >= 0.f ? 1.f : -1.f;
 	}
-	else DA_IF_CONSTEXPR (bits > 64)
+	else DA_IF_CONSTEXPR (bits >= 64)
 	{
 		return value;
 	}
@@ -227,14 +575,34 @@ float quantize(float value)
 	}
 	else
 	{
-		constexpr std::int64_t max = (1 << (bits - 1)) - 1;
+		constexpr std::int64_t max = (std::int64_t(1) << (bits - 1)) - 1;
 		return static_cast<float>(static_cast<std::int64_t>(value * max)) / max;
 	}
 #undef DA_IF_CONSTEXPR
 }
 
+template<unsigned bits>
+simd::float_4 quantize(simd::float_4 value)
+{
+	static_assert(bits > 0 && bits <= 24, "quantize<bits>(float_4) needs 1 to 24 bits");
+
+	constexpr std::int32_t max = (1 << (bits - 1)) - 1;
+	return simd::float_4(simd::int32_4(simd::clamp(value, -1.f, 1.f) * max)) / max;
+}
+
+template<>
+inline simd::float_4 quantize<1>(simd::float_4 value)
+{
+	return simd::ifelse(value >= 0.f, simd::float_4(1.f), simd::float_4(-1.f));
+}
+
 float quantize(float value, unsigned bits);
 
+using QuantizeKernel = simd::float_4 (*)(simd::float_4);
+
+// quantize<bits>(float_4) for a bit depth chosen at run time, from 1 to 24 bits; look it up once per block rather than per sample
+QuantizeKernel getQuantizeKernel(unsigned bits);
+
 } // namespace DigitalAtavism
 
 namespace da = DigitalAtavism;
@@ -1,8 +1,8 @@
-#include "DA.hpp"
+#include "DaSfxr.hpp"
 
 namespace DigitalAtavism {
 
-struct Blip : Module
+struct Blip : SfxrBase
 {
 	enum ParamIds
 	{
@@ -63,42 +63,61 @@ struct Blip : Module
 
 	struct Osc
 	{
-		enum { supersampling = 8, }; // could go down to 1, if required...
+		simd::int32_4 phase = 0;
+		simd::int32_4 period = 1;
 
-		int phase{};
-		int period{ 1 };
+		simd::float_4 fltp = 0.f;
+		simd::float_4 fltphp = 0.f;
 
-		float fltp{};
-		float fltphp{};
+		// restarts the cycle as if it had begun elapsed samples ago
+		template<int supersampling>
+		void resetPhase(simd::float_4 mask, simd::float_4 elapsed)
+		{
+			const simd::int32_4 offset = elapsed * supersampling + 0.5f;
+			phase = simd::ifelse(simd::int32_4::cast(mask), simd::ifelse(offset < period, offset, period - 1), phase);
+		}
 
-		void resetPhase()
+		void resetFilter(simd::float_4 mask)
 		{
-			phase = 0;
+			fltp = simd::ifelse(mask, simd::float_4::zero(), fltp);
+			fltphp = simd::ifelse(mask, simd::float_4::zero(), fltphp);
 		}
 
-		void resetFilter()
+		void rescale(int fromSupersampling, int toSupersampling)
 		{
-			fltp = 0.0f;
-			fltphp = 0.0f;
+			for (int i = 0; i < 4; ++i)
+			{
+				period[i] = clamp(period[i] * toSupersampling / fromSupersampling, toSupersampling, 12500 * toSupersampling);
+				phase[i] = phase[i] * toSupersampling / fromSupersampling % period[i];
+			}
 		}
 
-		void setOscPeriod(float sampleRate, float oscPeriod)
+		template<int supersampling>
+		void setOscPeriod(simd::float_4 mask, float sampleRate, simd::float_4 oscPeriod)
 		{
-			period = clamp(int(oscPeriod * sampleRate), supersampling, 12500 * supersampling);
+			const simd::int32_4 newPeriod = simd::clamp(oscPeriod * sampleRate, supersampling, 12500 * supersampling);
+			period = simd::ifelse(simd::int32_4::cast(mask), newPeriod, period);
+
+			// a shorter period can leave the phase out of range, which process() expects to wrap at most once
+			if (simd::movemask(phase >= period))
+				for (int i = 0; i < 4; ++i)
+					phase[i] %= period[i];
 		}
 
-		float process(float wave_type, float square_duty)
+		template<int supersampling>
+		simd::float_4 process(simd::float_4 wave_type, simd::float_4 square_duty)
 		{
-			float ret{};
-			const int duty = (int)(square_duty * period);
+			simd::float_4 ret = 0.f;
+			const simd::float_4 fperiod = period;
+			const simd::int32_4 duty = square_duty * fperiod;
 			for (int i = 0; i < supersampling; ++i)
 			{
-				++phase;
-				phase %= period;
+				phase += 1;
+				phase = simd::ifelse(phase >= period, simd::int32_4::zero(), phase);
 
 				// base waveform
-				const float fp = (float)phase / period;
-				const auto square = phase <= duty ? 0.5f : -0.5f;
+				const auto fp = simd::float_4(phase) / fperiod;
+				const auto square = simd::ifelse(simd::float_4::cast(phase <= duty), simd::float_4(0.5f), simd::float_4(-0.5f));
 				const auto sawtooth = 1.0f - fp * 2;
 				const auto sample = (1.0f - wave_type) * square + sawtooth * wave_type;
 
@@ -115,18 +134,42 @@ struct Blip : Module
 		}
 	};
 
-	rack::dsp::SchmittTrigger triggerPlay;
+	// voice state for four channels, so that up to 16 voices are processed in four SIMD passes
+	struct Voices
+	{
+		Osc osc;
+
+		// the outputs of the last rendered block
+		simd::float_4 mainFrames[maxBlockSize]{};
+		simd::float_4 envFrames[maxBlockSize]{};
+
+		// the outputs rendered at the render rate
+		Resampler mainResampler;
+		Resampler envResampler;
+
+		dsp::TRateReducer<simd::float_4> rateReducer;
+
+		void reset()
+		{
+			mainResampler.reset();
+			envResampler.reset();
+			rateReducer.reset();
+		}
+	};
 
-	Osc osc;
-	dsp::HrEnvelope envelope;
+	Voices voices[PORT_MAX_CHANNELS / 4];
+	// the voices' volume envelopes, one vector per group
+	dsp::HrEnvelopeBank<PORT_MAX_CHANNELS> envelopes;
 
 	void onReset() override
 	{
 		onSampleRateChange();
 
-		triggerPlay.reset();
+		resetRendering();
+		for (auto& voice : voices)
+			voice.reset();
+		envelopes.stop();
 
-		envelope.stop();
 		onRandomize();
 	}
 
@@ -134,59 +177,212 @@ struct Blip : Module
 	{
 		const auto timeRatio = 1.0f / 44100.0f;
 
-		const auto period = 100.0 / (da::math::sqr(0.2f + da::math::frnd() * 0.4f) + 0.001) * timeRatio;
-		params[FREQ_PARAM].setValue(log2f(osc.supersampling / rack::dsp::FREQ_C4 / period) * 12.0f);
+		const auto period = 100.0 / (da::math::sqr(0.2f + da::math::frnd(random) * 0.4f) + 0.001) * timeRatio;
+		params[FREQ_PARAM].setValue(log2f(sfxrSupersampling / rack::dsp::FREQ_C4 / period) * 12.0f);
 
-		const auto waveType = da::math::rnd<1>();
+		const auto waveType = da::math::rnd<1>(random);
 		params[TYPE_SELECTION_PARAM].setValue(waveType);
 
-		const auto holdTime = da::math::sqr(0.1f + da::math::frnd() * 0.1f) * 100000.0f * timeRatio;
+		const auto holdTime = da::math::sqr(0.1f + da::math::frnd(random) * 0.1f) * 100000.0f * timeRatio;
 		params[HOLD_TIME_PARAM].setValue(holdTime);
 
-		const auto releaseTime = da::math::sqr(da::math::frnd() * 0.2f) * 100000.0f * timeRatio;
+		const auto releaseTime = da::math::sqr(da::math::frnd(random) * 0.2f) * 100000.0f * timeRatio;
 		params[RELEASE_TIME_PARAM].setValue(releaseTime);
 
-		const auto squareDuty = 0.5f - da::math::frnd() * 0.3f;
+		const auto squareDuty = 0.5f - da::math::frnd(random) * 0.3f;
 		params[SQUARE_DUTY_PARAM].setValue(squareDuty);
 	}
 
 	void process(const ProcessArgs &args) override
 	{
-		const auto playTriggerInputConnected = inputs[TRIGGER_PLAY_INPUT].isConnected();
-		const auto playTriggered = triggerPlay.process(playTriggerInputConnected ? rescale(inputs[TRIGGER_PLAY_INPUT].getVoltage(), 0.1f, 2.f, 0.f, 1.f) : 0.f);
+		const auto channels = std::max({ 1, inputs[PITCH_INPUT].getChannels(), inputs[BLEND_INPUT].getChannels(), inputs[SQUARE_DUTY_INPUT].getChannels(),
+			inputs[HOLD_TIME_INPUT].getChannels(), inputs[RELEASE_TIME_INPUT].getChannels(), inputs[TRIGGER_PLAY_INPUT].getChannels() });
+
+		if (captureFrame(inputs[TRIGGER_PLAY_INPUT], inputs[PITCH_INPUT], channels))
+		{
+			const auto requestedSupersampling = supersampling;
+			if (requestedSupersampling != renderedSupersampling)
+			{
+				for (auto& voice : voices)
+					voice.osc.rescale(renderedSupersampling, requestedSupersampling);
+
+				renderedSupersampling = requestedSupersampling;
+			}
+
+			switch (renderedSupersampling)
+			{
+			case 1: renderBlock<1>(args, channels); break;
+			case 2: renderBlock<2>(args, channels); break;
+			case 4: renderBlock<4>(args, channels); break;
+			case 8: renderBlock<8>(args, channels); break;
+			case 16: renderBlock<16>(args, channels); break;
+			}
 
-		if (playTriggered || !playTriggerInputConnected)
+			startBlock(channels);
+		}
+
+		const auto frame = getOutputFrame();
+
+		outputs[VOLUME_ENV_OUTPUT].setChannels(block.renderedChannels);
+		outputs[MAIN_OUTPUT].setChannels(block.renderedChannels);
+
+		for (int c = 0; c < block.renderedChannels; c += 4)
 		{
-			const auto oscPeriod = osc.supersampling / rack::dsp::FREQ_C4 * exp2f(-params[FREQ_PARAM].getValue() / 12.0f - inputs[PITCH_INPUT].getVoltage());
-			osc.setOscPeriod(args.sampleRate, oscPeriod);
+			const auto& voice = voices[c / 4];
+			outputs[MAIN_OUTPUT].setVoltageSimd(voice.mainFrames[frame], c);
+			outputs[VOLUME_ENV_OUTPUT].setVoltageSimd(voice.envFrames[frame], c);
 		}
+	}
+
+	template<int oscSupersampling>
+	void renderBlock(const ProcessArgs &args, int channels)
+	{
+		const auto sampleRate = scheduleBlock(args.sampleRate);
+		const auto mainBitDepth = bitDepth;
+		const auto quantizeMain = getQuantizeKernel(mainBitDepth);
+		const auto mainRateReduction = rateReduction;
+		if (resampling.active && resampling.restarted)
+			for (auto& voice : voices)
+			{
+				voice.mainResampler.reset();
+				voice.envResampler.reset();
+			}
+
+		const auto playTriggerInputConnected = inputs[TRIGGER_PLAY_INPUT].isConnected();
+		const auto frequency = params[FREQ_PARAM].getValue();
 
-		if (playTriggered)
+		// unpatched outputs are not rendered; the envelope always runs, as it decides when voices go idle
+		const auto mainConnected = outputs[MAIN_OUTPUT].isConnected();
+		const auto envConnected = outputs[VOLUME_ENV_OUTPUT].isConnected();
+		const auto connectedOutputs = static_cast<float>(mainConnected | envConnected << 1);
+
+		const auto caching = startCaching(playTriggerInputConnected);
+
+		for (int c = 0; c < channels; c += 4)
 		{
-			osc.resetPhase();
-			osc.resetFilter();
+			auto& voice = voices[c / 4];
+			const auto lanes = std::min(channels - c, 4);
+			const auto laneBits = (1 << lanes) - 1;
+			const auto anyPlayTriggered = block.findTrigger(0, c) < block.size;
+
+			// the values triggers start the voices with, read once per block
+			simd::float_4 oscPeriod = 1.f;
+			if (anyPlayTriggered || !playTriggerInputConnected)
+				oscPeriod = oscSupersampling / rack::dsp::FREQ_C4 * math::fastExp2(-frequency / 12.0f - inputs[PITCH_INPUT].getPolyVoltageSimd<simd::float_4>(c));
+
+			simd::float_4 holdTime = params[HOLD_TIME_PARAM].getValue();
+			simd::float_4 releaseTime = params[RELEASE_TIME_PARAM].getValue();
+			if (anyPlayTriggered)
+			{
+				if (inputs[HOLD_TIME_INPUT].isConnected())
+					holdTime = simd::clamp(holdTime * math::fastExp2(inputs[HOLD_TIME_INPUT].getPolyVoltageSimd<simd::float_4>(c)), 0.0005f, 0.5f);
 
-			auto holdTime = params[HOLD_TIME_PARAM].getValue();
-			if (inputs[HOLD_TIME_INPUT].isConnected())
-				holdTime = clamp(holdTime * exp2f(inputs[HOLD_TIME_INPUT].getVoltage()), 0.0005f, 0.5f);
+				if (inputs[RELEASE_TIME_INPUT].isConnected())
+					releaseTime = simd::fmin(simd::fmax(releaseTime, 0.00001f) * math::fastExp2(inputs[RELEASE_TIME_INPUT].getPolyVoltageSimd<simd::float_4>(c)), 0.5f);
+			}
 
-			auto releaseTime = params[RELEASE_TIME_PARAM].getValue();
-			if (inputs[RELEASE_TIME_INPUT].isConnected())
-				releaseTime = std::min(std::max(releaseTime, 0.00001f) * exp2f(inputs[RELEASE_TIME_INPUT].getVoltage()), 0.5f);
+			const auto wave_type = simd::clamp(params[TYPE_SELECTION_PARAM].getValue() + inputs[BLEND_INPUT].getPolyVoltageSimd<simd::float_4>(c) * 0.1f, 0.0f, 1.0f);
+			const auto square_duty = simd::clamp(params[SQUARE_DUTY_PARAM].getValue() + inputs[SQUARE_DUTY_INPUT].getPolyVoltageSimd<simd::float_4>(c) * 0.1f, 0.01f, 0.99f);
 
-			envelope.start(args.sampleRate, holdTime, releaseTime, 0.0f);
-		}
+			if (!playTriggerInputConnected)
+				voice.osc.setOscPeriod<oscSupersampling>(simd::float_4::mask(), sampleRate, oscPeriod);
 
-		const float wave_type = clamp(params[TYPE_SELECTION_PARAM].getValue() + inputs[BLEND_INPUT].getVoltage() * 0.1f, 0.0f, 1.0f);
-		const float square_duty = clamp(params[SQUARE_DUTY_PARAM].getValue() + inputs[SQUARE_DUTY_INPUT].getVoltage() * 0.1f, 0.01f, 0.99f);
-		const auto sample = osc.process(wave_type, square_duty);
-		const auto env = envelope.process();
-		const auto out = !playTriggerInputConnected ? sample : sample * env;
-		outputs[MAIN_OUTPUT].setVoltage(quantize<8>(out) * 5.0f);
-		outputs[VOLUME_ENV_OUTPUT].setVoltage(quantize<8>(env) * 10.0f);
+			// renders one frame at sampleRate: the main and volume envelope outputs
+			auto renderFrame = [&](int frame, simd::float_4* values)
+			{
+				// triggered voices are silent between one-shots, and a trigger resets all the state they would advance,
+				// so idle groups skip the oscillator, filters and quantizer and output zeros
+				if (!playTriggerInputConnected || (simd::movemask(envelopes.isActive(c / 4)) & laneBits))
+				{
+					const auto env = envelopes.process(c / 4);
+
+					if (mainConnected)
+					{
+						if (block.trackPitch)
+							voice.osc.setOscPeriod<oscSupersampling>(simd::float_4::mask(), sampleRate,
+								oscSupersampling / rack::dsp::FREQ_C4 * math::fastExp2(-frequency / 12.0f - block.pitch[frame][c / 4]));
+
+						const auto sample = voice.osc.process<oscSupersampling>(wave_type, square_duty);
+						const auto out = !playTriggerInputConnected ? sample : sample * env;
+						if (voice.rateReducer.advance(mainRateReduction))
+							voice.rateReducer.value = quantizeMain(out) * 5.0f;
+
+						values[0] = voice.rateReducer.value;
+					}
+
+					if (envConnected)
+						values[1] = quantize<8>(env) * 10.0f;
+				}
+				else
+					voice.rateReducer.reset();
+			};
+
+			for (int frame = 0; frame < block.size;)
+			{
+				auto playTriggered = block.getTriggers(frame, c);
+				if (simd::movemask(playTriggered))
+				{
+					if (block.trackPitch)
+						oscPeriod = oscSupersampling / rack::dsp::FREQ_C4 * math::fastExp2(-frequency / 12.0f - block.pitch[frame][c / 4]);
+
+					// triggers rarely land on a sample: the oscillators and envelopes start as far along as the edge came early,
+					// rounded while caching to the steps that replayed one-shots match by their key
+					auto elapsed = block.elapsed[frame][c / 4] * (sampleRate / args.sampleRate);
+
+					if (caching)
+					{
+						elapsed = OneShotCache::quantizeElapsed(elapsed);
+						const auto replayed = startOneShots(c, lanes, playTriggered, [&](int i) {
+							return OneShotCache::Key{ args.sampleRate, sampleRate, static_cast<float>(oscSupersampling), oscPeriod[i], holdTime[i], releaseTime[i], wave_type[i], square_duty[i], static_cast<float>(mainBitDepth), static_cast<float>(mainRateReduction), connectedOutputs, elapsed[i] };
+						});
+						envelopes.stop(c / 4, replayed);
+						playTriggered = simd::andnot(replayed, playTriggered);
+					}
+
+					voice.osc.setOscPeriod<oscSupersampling>(playTriggered, sampleRate, oscPeriod);
+					voice.osc.resetPhase<oscSupersampling>(playTriggered, elapsed);
+					voice.osc.resetFilter(playTriggered);
+
+					envelopes.start(c / 4, playTriggered, sampleRate, holdTime, releaseTime, 0.0f, elapsed);
+				}
+
+				// the frames up to the next trigger run without any per-sample bookkeeping
+				const auto end = block.findTrigger(frame + 1, c);
+				for (; frame < end; ++frame)
+				{
+					// the main and volume envelope outputs
+					simd::float_4 frameOutputs[2] = {};
+					const auto active = envelopes.isActive(c / 4);
+
+					if (!resampling.active)
+						renderFrame(frame, frameOutputs);
+					else
+					{
+						for (int step = 0; step < resampling.steps[frame]; ++step)
+						{
+							simd::float_4 rendered[2] = {};
+							renderFrame(frame, rendered);
+							voice.mainResampler.push(rendered[0]);
+							voice.envResampler.push(rendered[1]);
+						}
+
+						if (mainConnected)
+							frameOutputs[0] = voice.mainResampler.process(resampling.rows[frame]);
+						if (envConnected)
+							frameOutputs[1] = voice.envResampler.process(resampling.rows[frame]);
+					}
+
+					if (caching)
+						cacheFrame(c, lanes, ~active, frameOutputs, 2);
+
+					voice.mainFrames[frame] = frameOutputs[0];
+					voice.envFrames[frame] = frameOutputs[1];
+				}
+			}
+		}
 	}
 
-	struct Widget : gui::BaseModuleWidget
+	struct Widget : BaseWidget
 	{
 		using MyModule = Blip;
 
@@ -1,8 +1,8 @@
-#include "DA.hpp"
+#include "DaSfxr.hpp"
 
 namespace DigitalAtavism {
 
-struct Coin : Module
+struct Coin : SfxrBase
 {
 	enum ParamIds
 	{
@@ -65,52 +65,118 @@ struct Coin : Module
 
 	struct Osc
 	{
-		enum { supersampling = 8, }; // could go down to 1, if required...
+		simd::int32_4 phase = 0;
+		simd::int32_4 period = 1;
 
-		int phase{};
-		int period{ 1 };
-
-		void resetPhase()
+		// restarts the cycle as if it had begun elapsed samples ago
+		template<int supersampling>
+		void resetPhase(simd::float_4 mask, simd::float_4 elapsed)
 		{
-			phase = 0;
+			const simd::int32_4 offset = elapsed * supersampling + 0.5f;
+			phase = simd::ifelse(simd::int32_4::cast(mask), simd::ifelse(offset < period, offset, period - 1), phase);
 		}
 
-		void setOscPeriod(float sampleRate, float oscPeriod)
+		template<int supersampling>
+		void setOscPeriod(simd::float_4 mask, float sampleRate, simd::float_4 oscPeriod)
 		{
-			period = clamp(int(oscPeriod * sampleRate), supersampling, 12500 * supersampling);
+			const simd::int32_4 newPeriod = simd::clamp(oscPeriod * sampleRate, supersampling, 12500 * supersampling);
+			period = simd::ifelse(simd::int32_4::cast(mask), newPeriod, period);
+
+			// a shorter period can leave the phase out of range, which process() expects to wrap at most once
+			if (simd::movemask(phase >= period))
+				for (int i = 0; i < 4; ++i)
+					phase[i] %= period[i];
 		}
 
-		float process()
+		void rescale(int fromSupersampling, int toSupersampling)
 		{
-			int ret{};
-			for (int i = 0; i < supersampling; ++i)
+			for (int i = 0; i < 4; ++i)
 			{
-				++phase;
-				phase %= period;
-				ret += (phase * 2 / period == 0) * 2 - 1;
+				period[i] = clamp(period[i] * toSupersampling / fromSupersampling, toSupersampling, 12500 * toSupersampling);
+				phase[i] = phase[i] * toSupersampling / fromSupersampling % period[i];
 			}
+		}
 
-			return (float)ret / 2 / supersampling;
+		// Averages the square wave over the next supersampling phases without stepping through them.
+		// Those phases are phase + 1 ... phase + supersampling, wrapped at most once since period >= supersampling,
+		// and each one is high while phase * 2 < period, i.e. phase < (period + 1) / 2.
+		template<int supersampling>
+		simd::float_4 process()
+		{
+			const auto first = phase + 1;
+			const auto last = phase + supersampling;
+			const auto wraps = last >= period;
+			const auto highEnd = (period + 1) >> 1;
+
+			// high phases in [first, min(last, period - 1)], then in [0, last - period] after the wrap
+			const auto end = simd::ifelse(wraps, period, last + 1);
+			const auto beforeWrap = simd::ifelse(end < highEnd, end, highEnd) - first;
+			const auto wrapped = last - period + 1;
+			const auto afterWrap = wraps & simd::ifelse(wrapped < highEnd, wrapped, highEnd);
+			const auto high = simd::ifelse(beforeWrap > simd::int32_4::zero(), beforeWrap, simd::int32_4::zero()) + afterWrap;
+
+			phase = simd::ifelse(wraps, last - period, last);
+
+			const auto ret = (high << 1) - supersampling;
+			return simd::float_4(ret) / 2.f / supersampling;
 		}
 	};
 
-	rack::dsp::SchmittTrigger triggerPlay;
-	dsp::TimedTrigger freqModTrigger;
-	rack::dsp::PulseGenerator freqModTimePulseGenerator;
+	// voice state for four channels, so that up to 16 voices are processed in four SIMD passes
+	struct Voices
+	{
+		dsp::TTickTrigger<simd::float_4> freqModTrigger;
+		dsp::TTickPulseGenerator<simd::float_4> freqModTimePulseGenerator;
+
+		Osc osc;
+		simd::float_4 oscPeriod = 1.0f;
+		// the period ratio the frequency modulation has jumped to, 1 until it fires
+		simd::float_4 freqModScale = 1.0f;
+
+		// the outputs of the last rendered block
+		simd::float_4 mainFrames[maxBlockSize]{};
+		simd::float_4 envFrames[maxBlockSize]{};
+		simd::float_4 freqModTriggerFrames[maxBlockSize]{};
 
-	Osc osc;
-	float oscPeriod{ 1.0f };
-	dsp::HrEnvelope envelope;
+		// the main and volume envelope outputs rendered at the render rate; the frequency mod trigger output holds
+		// its last rendered value instead, to keep its edges sharp
+		Resampler mainResampler;
+		Resampler envResampler;
+
+		dsp::TRateReducer<simd::float_4> rateReducer;
+		simd::float_4 freqModTriggerHeld = 0.f;
+
+		void rescale(int fromSupersampling, int toSupersampling)
+		{
+			osc.rescale(fromSupersampling, toSupersampling);
+			oscPeriod *= static_cast<float>(toSupersampling) / fromSupersampling;
+		}
+
+		void reset()
+		{
+			freqModTrigger.reset();
+			freqModTimePulseGenerator.reset();
+
+			mainResampler.reset();
+			envResampler.reset();
+			rateReducer.reset();
+			freqModTriggerHeld = 0.f;
+		}
+	};
+
+	Voices voices[PORT_MAX_CHANNELS / 4];
+	// the voices' volume envelopes, one vector per group
+	dsp::HrEnvelopeBank<PORT_MAX_CHANNELS> envelopes;
 
 	void onReset() override
 	{
 		onSampleRateChange();
 
-		triggerPlay.reset();
-		freqModTrigger.reset();
-		freqModTimePulseGenerator.reset();
+		resetRendering();
+		for (auto& voice : voices)
+			voice.reset();
+		envelopes.stop();
 
-		envelope.stop();
 		onRandomize();
 	}
 
@@ -118,82 +184,262 @@ struct Coin : Module
 	{
 		const auto timeRatio = 1.0f / 44100.0f;
 
-		const auto period = 100.0f / (da::math::sqr(0.4f + da::math::frnd() * 0.5f) + 0.001f) * timeRatio;
-		params[FREQ_PARAM].setValue(log2f(osc.supersampling / rack::dsp::FREQ_C4 / period) * 12.0f);
+		const auto period = 100.0f / (da::math::sqr(0.4f + da::math::frnd(random) * 0.5f) + 0.001f) * timeRatio;
+		params[FREQ_PARAM].setValue(log2f(sfxrSupersampling / rack::dsp::FREQ_C4 / period) * 12.0f);
 
-		const auto holdTime = da::math::sqr(da::math::frnd() * 0.1f) * 100000.0f * timeRatio;
+		const auto holdTime = da::math::sqr(da::math::frnd(random) * 0.1f) * 100000.0f * timeRatio;
 		params[HOLD_TIME_PARAM].setValue(holdTime);
 
-		const auto releaseTime = da::math::sqr(0.1f + da::math::frnd() * 0.4f) * 100000.0f * timeRatio;
+		const auto releaseTime = da::math::sqr(0.1f + da::math::frnd(random) * 0.4f) * 100000.0f * timeRatio;
 		params[RELEASE_TIME_PARAM].setValue(releaseTime);
 
-		const auto punchAmount = 0.3f + da::math::frnd() * 0.3f;
+		const auto punchAmount = 0.3f + da::math::frnd(random) * 0.3f;
 		params[PUNCH_PARAM].setValue(punchAmount);
 
 		auto freqChangeTime = 0.0f;
-		if (da::math::rnd<1>() == 1)
-			freqChangeTime = (da::math::sqr(0.5f - da::math::frnd() * 0.2f) * 20000 + 32) * timeRatio;
+		if (da::math::rnd<1>(random) == 1)
+			freqChangeTime = (da::math::sqr(0.5f - da::math::frnd(random) * 0.2f) * 20000 + 32) * timeRatio;
 
 		params[FREQ_MOD_TIME_PARAM].setValue(freqChangeTime);
 
 		const auto sampleRate = APP->engine->getSampleRate();
-		const auto freqModAmount = 1.0f - da::math::sqr(0.2f + da::math::frnd() * 0.4f) * 0.9f;
+		const auto freqModAmount = 1.0f - da::math::sqr(0.2f + da::math::frnd(random) * 0.4f) * 0.9f;
 		params[FREQ_MOD_PARAM].setValue(log2f(freqModAmount) * -12.0f * 44100.0f / sampleRate);
 	}
 
 	void process(const ProcessArgs &args) override
 	{
-		const auto playTriggerInputConnected = inputs[TRIGGER_PLAY_INPUT].isConnected();
-		const auto playTriggered = triggerPlay.process(playTriggerInputConnected ? rescale(inputs[TRIGGER_PLAY_INPUT].getVoltage(), 0.1f, 2.f, 0.f, 1.f) : 0.f);
+		const auto channels = std::max({ 1, inputs[PITCH_INPUT].getChannels(), inputs[PITCH_MOD_INPUT].getChannels(), inputs[FREQ_MOD_TIME_INPUT].getChannels(),
+			inputs[HOLD_TIME_INPUT].getChannels(), inputs[RELEASE_TIME_INPUT].getChannels(), inputs[TRIGGER_PLAY_INPUT].getChannels() });
 
-		if (playTriggered || !playTriggerInputConnected)
+		if (captureFrame(inputs[TRIGGER_PLAY_INPUT], inputs[PITCH_INPUT], channels))
 		{
-			oscPeriod = osc.supersampling / rack::dsp::FREQ_C4 * exp2f(-params[FREQ_PARAM].getValue() / 12.0f - inputs[PITCH_INPUT].getVoltage());
-			osc.setOscPeriod(args.sampleRate, oscPeriod);
+			const auto requestedSupersampling = supersampling;
+			if (requestedSupersampling != renderedSupersampling)
+			{
+				for (auto& voice : voices)
+					voice.rescale(renderedSupersampling, requestedSupersampling);
+
+				renderedSupersampling = requestedSupersampling;
+			}
+
+			switch (renderedSupersampling)
+			{
+			case 1: renderBlock<1>(args, channels); break;
+			case 2: renderBlock<2>(args, channels); break;
+			case 4: renderBlock<4>(args, channels); break;
+			case 8: renderBlock<8>(args, channels); break;
+			case 16: renderBlock<16>(args, channels); break;
+			}
+
+			startBlock(channels);
 		}
 
-		if (!playTriggerInputConnected)
+		const auto frame = getOutputFrame();
+
+		outputs[FREQ_MOD_TRIGGER_OUTPUT].setChannels(block.renderedChannels);
+		outputs[VOLUME_ENV_OUTPUT].setChannels(block.renderedChannels);
+		outputs[MAIN_OUTPUT].setChannels(block.renderedChannels);
+
+		for (int c = 0; c < block.renderedChannels; c += 4)
 		{
-			freqModTrigger.reset();
+			const auto& voice = voices[c / 4];
+			outputs[MAIN_OUTPUT].setVoltageSimd(voice.mainFrames[frame], c);
+			outputs[VOLUME_ENV_OUTPUT].setVoltageSimd(voice.envFrames[frame], c);
+			outputs[FREQ_MOD_TRIGGER_OUTPUT].setVoltageSimd(voice.freqModTriggerFrames[frame], c);
 		}
-		else if (playTriggered)
-		{
-			auto freqChangeTime = params[FREQ_MOD_TIME_PARAM].getValue();
-			if (inputs[FREQ_MOD_TIME_INPUT].isConnected())
-				freqChangeTime = std::min(std::max(freqChangeTime, 0.00001f) * exp2f(inputs[FREQ_MOD_TIME_INPUT].getVoltage()), 0.8f);
+	}
 
-			freqModTrigger.trigger(freqChangeTime);
+	template<int oscSupersampling>
+	void renderBlock(const ProcessArgs &args, int channels)
+	{
+		const auto sampleRate = scheduleBlock(args.sampleRate);
+		const auto mainBitDepth = bitDepth;
+		const auto quantizeMain = getQuantizeKernel(mainBitDepth);
+		const auto mainRateReduction = rateReduction;
+		const auto pulseSamples = simd::int32_4(math::toSamples(1e-3f, sampleRate));
+		if (resampling.active && resampling.restarted)
+			for (auto& voice : voices)
+			{
+				voice.mainResampler.reset();
+				voice.envResampler.reset();
+			}
 
-			osc.resetPhase();
+		const auto playTriggerInputConnected = inputs[TRIGGER_PLAY_INPUT].isConnected();
+		const auto frequency = params[FREQ_PARAM].getValue();
+
+		// unpatched outputs are not rendered; the envelope always runs, as it decides when voices go idle
+		const auto mainConnected = outputs[MAIN_OUTPUT].isConnected();
+		const auto envConnected = outputs[VOLUME_ENV_OUTPUT].isConnected();
+		const auto freqModTriggerConnected = outputs[FREQ_MOD_TRIGGER_OUTPUT].isConnected();
+		const auto connectedOutputs = static_cast<float>(mainConnected | envConnected << 1 | freqModTriggerConnected << 2);
+
+		const auto caching = startCaching(playTriggerInputConnected);
+
+		for (int c = 0; c < channels; c += 4)
+		{
+			auto& voice = voices[c / 4];
+			const auto lanes = std::min(channels - c, 4);
+			const auto laneBits = (1 << lanes) - 1;
+			const auto anyPlayTriggered = block.findTrigger(0, c) < block.size;
+
+			// the values triggers start the voices with, read once per block
+			auto oscPeriod = voice.oscPeriod;
+			if (anyPlayTriggered || !playTriggerInputConnected)
+				oscPeriod = oscSupersampling / rack::dsp::FREQ_C4 * math::fastExp2(-frequency / 12.0f - inputs[PITCH_INPUT].getPolyVoltageSimd<simd::float_4>(c));
+
+			simd::float_4 freqChangeTime = params[FREQ_MOD_TIME_PARAM].getValue();
+			simd::float_4 holdTime = params[HOLD_TIME_PARAM].getValue();
+			simd::float_4 releaseTime = params[RELEASE_TIME_PARAM].getValue();
+			if (anyPlayTriggered)
+			{
+				if (inputs[FREQ_MOD_TIME_INPUT].isConnected())
+					freqChangeTime = simd::fmin(simd::fmax(freqChangeTime, 0.00001f) * math::fastExp2(inputs[FREQ_MOD_TIME_INPUT].getPolyVoltageSimd<simd::float_4>(c)), 0.8f);
 
-			auto holdTime = params[HOLD_TIME_PARAM].getValue();
-			if (inputs[HOLD_TIME_INPUT].isConnected())
-				holdTime = clamp(holdTime * exp2f(inputs[HOLD_TIME_INPUT].getVoltage()), 0.0005f, 0.5f);
+				if (inputs[HOLD_TIME_INPUT].isConnected())
+					holdTime = simd::clamp(holdTime * math::fastExp2(inputs[HOLD_TIME_INPUT].getPolyVoltageSimd<simd::float_4>(c)), 0.0005f, 0.5f);
 
-			auto releaseTime = params[RELEASE_TIME_PARAM].getValue();
-			if (inputs[RELEASE_TIME_INPUT].isConnected())
-				releaseTime = std::min(std::max(releaseTime, 0.00001f) * exp2f(inputs[RELEASE_TIME_INPUT].getVoltage()), 0.5f);
+				if (inputs[RELEASE_TIME_INPUT].isConnected())
+					releaseTime = simd::fmin(simd::fmax(releaseTime, 0.00001f) * math::fastExp2(inputs[RELEASE_TIME_INPUT].getPolyVoltageSimd<simd::float_4>(c)), 0.5f);
+			}
 
 			const auto punchAmount = params[PUNCH_PARAM].getValue();
-			envelope.start(args.sampleRate, holdTime, releaseTime, punchAmount);
-		}
+			const auto freqModAmount = params[FREQ_MOD_PARAM].getValue();
+			const auto pitchMod = inputs[PITCH_MOD_INPUT].getPolyVoltageSimd<simd::float_4>(c);
 
-		if (freqModTrigger.process(args.sampleTime))
-		{
-			const auto freqModAmount = exp2f(-params[FREQ_MOD_PARAM].getValue() / 12 - inputs[PITCH_MOD_INPUT].getVoltage());
-			osc.setOscPeriod(args.sampleRate, oscPeriod * freqModAmount);
-			freqModTimePulseGenerator.trigger(1e-3f);
-		}
+			if (!playTriggerInputConnected)
+			{
+				voice.oscPeriod = oscPeriod;
+				voice.osc.setOscPeriod<oscSupersampling>(simd::float_4::mask(), sampleRate, voice.oscPeriod);
+				voice.freqModTrigger.reset();
+				voice.freqModScale = 1.f;
+			}
+
+			if (!freqModTriggerConnected)
+				voice.freqModTimePulseGenerator.reset();
 
-		const auto sample = osc.process();
-		const auto env = envelope.process();
-		const auto out = !playTriggerInputConnected ? sample : sample * env;
-		outputs[MAIN_OUTPUT].setVoltage(quantize<8>(out) * 5.0f);
-		outputs[VOLUME_ENV_OUTPUT].setVoltage(quantize<8>(env) * 10.0f);
-		outputs[FREQ_MOD_TRIGGER_OUTPUT].setVoltage(freqModTimePulseGenerator.process(args.sampleTime) * 10.0f);
+			// renders one frame at sampleRate: the main, volume envelope and frequency mod trigger outputs
+			auto renderFrame = [&](int frame, simd::float_4* values)
+			{
+				const auto active = envelopes.isActive(c / 4);
+
+				// triggered voices are silent between one-shots, and a trigger resets all the oscillator state, so idle
+				// groups skip the oscillator and quantizer and output zeros; the frequency mod timer keeps running
+				const auto sounding = !playTriggerInputConnected || (simd::movemask(active) & laneBits);
+
+				if (sounding && mainConnected && block.trackPitch)
+				{
+					voice.oscPeriod = oscSupersampling / rack::dsp::FREQ_C4 * math::fastExp2(-frequency / 12.0f - block.pitch[frame][c / 4]);
+					voice.osc.setOscPeriod<oscSupersampling>(simd::float_4::mask(), sampleRate, voice.oscPeriod * voice.freqModScale);
+				}
+
+				const auto freqModTriggered = voice.freqModTrigger.process();
+				if (simd::movemask(freqModTriggered))
+				{
+					voice.freqModScale = simd::ifelse(freqModTriggered, math::fastExp2(-freqModAmount / 12 - pitchMod), voice.freqModScale);
+					voice.osc.setOscPeriod<oscSupersampling>(freqModTriggered, sampleRate, voice.oscPeriod * voice.freqModScale);
+					if (freqModTriggerConnected)
+						voice.freqModTimePulseGenerator.trigger(freqModTriggered, pulseSamples);
+				}
+
+				if (sounding)
+				{
+					const auto env = envelopes.process(c / 4);
+
+					if (mainConnected)
+					{
+						const auto sample = voice.osc.process<oscSupersampling>();
+						const auto out = !playTriggerInputConnected ? sample : sample * env;
+						if (voice.rateReducer.advance(mainRateReduction))
+							voice.rateReducer.value = quantizeMain(out) * 5.0f;
+
+						values[0] = voice.rateReducer.value;
+					}
+
+					if (envConnected)
+						values[1] = quantize<8>(env) * 10.0f;
+				}
+				else
+					voice.rateReducer.reset();
+
+				if (freqModTriggerConnected)
+					values[2] = voice.freqModTimePulseGenerator.process() & simd::float_4(10.0f);
+			};
+
+			for (int frame = 0; frame < block.size;)
+			{
+				auto playTriggered = block.getTriggers(frame, c);
+				if (simd::movemask(playTriggered))
+				{
+					if (block.trackPitch)
+						oscPeriod = oscSupersampling / rack::dsp::FREQ_C4 * math::fastExp2(-frequency / 12.0f - block.pitch[frame][c / 4]);
+
+					// triggers rarely land on a sample: the oscillators and envelopes start as far along as the edge came early,
+					// rounded while caching to the steps that replayed one-shots match by their key
+					auto elapsed = block.elapsed[frame][c / 4] * (sampleRate / args.sampleRate);
+
+					if (caching)
+					{
+						elapsed = OneShotCache::quantizeElapsed(elapsed);
+						const auto replayed = startOneShots(c, lanes, playTriggered, [&](int i) {
+							return OneShotCache::Key{ args.sampleRate, sampleRate, static_cast<float>(oscSupersampling), oscPeriod[i], freqChangeTime[i],
+								freqModAmount, pitchMod[i], holdTime[i], releaseTime[i], punchAmount, static_cast<float>(mainBitDepth), static_cast<float>(mainRateReduction), connectedOutputs, elapsed[i] };
+						});
+						envelopes.stop(c / 4, replayed);
+						playTriggered = simd::andnot(replayed, playTriggered);
+					}
+
+					voice.oscPeriod = simd::ifelse(playTriggered, oscPeriod, voice.oscPeriod);
+					voice.freqModScale = simd::ifelse(playTriggered, simd::float_4(1.f), voice.freqModScale);
+					voice.osc.setOscPeriod<oscSupersampling>(playTriggered, sampleRate, voice.oscPeriod);
+
+					voice.freqModTrigger.trigger(playTriggered, math::toSamples(freqChangeTime, sampleRate));
+
+					voice.osc.resetPhase<oscSupersampling>(playTriggered, elapsed);
+
+					envelopes.start(c / 4, playTriggered, sampleRate, holdTime, releaseTime, punchAmount, elapsed);
+				}
+
+				// the frames up to the next trigger run without any per-sample bookkeeping
+				const auto end = block.findTrigger(frame + 1, c);
+				for (; frame < end; ++frame)
+				{
+					// the main, volume envelope and frequency mod trigger outputs
+					simd::float_4 frameOutputs[3] = {};
+					const auto done = ~(envelopes.isActive(c / 4) | voice.freqModTrigger.isActive() | voice.freqModTimePulseGenerator.isActive());
+
+					if (!resampling.active)
+						renderFrame(frame, frameOutputs);
+					else
+					{
+						for (int step = 0; step < resampling.steps[frame]; ++step)
+						{
+							simd::float_4 rendered[3] = {};
+							renderFrame(frame, rendered);
+							voice.mainResampler.push(rendered[0]);
+							voice.envResampler.push(rendered[1]);
+							voice.freqModTriggerHeld = rendered[2];
+						}
+
+						if (mainConnected)
+							frameOutputs[0] = voice.mainResampler.process(resampling.rows[frame]);
+						if (envConnected)
+							frameOutputs[1] = voice.envResampler.process(resampling.rows[frame]);
+						frameOutputs[2] = voice.freqModTriggerHeld;
+					}
+
+					if (caching)
+						cacheFrame(c, lanes, done, frameOutputs, 3);
+
+					voice.mainFrames[frame] = frameOutputs[0];
+					voice.envFrames[frame] = frameOutputs[1];
+					voice.freqModTriggerFrames[frame] = frameOutputs[2];
+				}
+			}
+		}
 	}
 
-	struct Widget : gui::BaseModuleWidget
+	struct Widget : BaseWidget
 	{
 		using MyModule = Coin;
 
@@ -45,38 +45,145 @@ struct DTrig : Module
 		onReset();
 	}
 
-	rack::dsp::SchmittTrigger triggerPlay;
-	dsp::TimedTrigger outputTrigger;
-	rack::dsp::PulseGenerator pulseGenerator;
-	
-	void onReset() override
+	enum { maxQueueCapacity = 64 };
+
+	// the pending delays fall due in fixed point, with this many bits below the sample
+	enum { subSampleBits = 8 };
+
+	// pending delays per channel; triggers arriving while this many are pending are dropped
+	int queueCapacity{ 16 };
+	// triggers dropped since the counter was last cleared
+	std::uint32_t droppedTriggers{};
+
+	// samples processed, which the pending delays fall due against
+	std::int64_t clock{};
+
+	// every trigger schedules its own delay; the gates are four channels to a vector
+	dsp::TSubSampleTrigger<simd::float_4> triggerPlay[PORT_MAX_CHANNELS / 4];
+	dsp::EventQueue<std::int64_t, maxQueueCapacity> pendingTriggers[PORT_MAX_CHANNELS];
+	dsp::TTickPulseGenerator<simd::float_4> pulseGenerator[PORT_MAX_CHANNELS / 4];
+
+	static bool isQueueCapacitySupported(int value)
 	{
-		triggerPlay.reset();
-		outputTrigger.reset();
-		pulseGenerator.reset();
+		return value >= 1 && value <= maxQueueCapacity;
 	}
 
-	void process(const ProcessArgs &args) override
+	void onReset() override
 	{
-		if (triggerPlay.process(rescale(inputs[TRIGGER_PLAY_INPUT].getVoltage(), 0.1f, 2.f, 0.f, 1.f)) || (!outputTrigger.isActive() && !inputs[TRIGGER_PLAY_INPUT].isConnected()))
+		for (int i = 0; i < PORT_MAX_CHANNELS / 4; ++i)
 		{
-			auto delayTime = params[DELAY_TIME_PARAM].getValue();
-			if (inputs[DELAY_TIME_INPUT].isConnected())
-				delayTime = std::min(delayTime * exp2f(inputs[DELAY_TIME_INPUT].getVoltage()), 5.f);
+			triggerPlay[i].reset();
+			pulseGenerator[i].reset();
+		}
+
+		for (auto& pending : pendingTriggers)
+			pending.reset();
+
+		droppedTriggers = 0;
+	}
 
-			outputTrigger.trigger(delayTime);
+	json_t* dataToJson() override
+	{
+		if (json_t* rootJ = json_object())
+		{
+			json_object_set_new(rootJ, "queueCapacity", json_integer(queueCapacity));
+			return rootJ;
 		}
 
-		if (outputTrigger.process(args.sampleTime))
+		return nullptr;
+	}
+
+	void dataFromJson(json_t* rootJ) override
+	{
+		queueCapacity = 16;
+
+		if (rootJ)
+			if (auto queueCapacityJson = json_object_get(rootJ, "queueCapacity"))
+				if (isQueueCapacitySupported(json_integer_value(queueCapacityJson)))
+					queueCapacity = json_integer_value(queueCapacityJson);
+	}
+
+	void process(const ProcessArgs &args) override
+	{
+		const auto channels = std::max({ 1, inputs[DELAY_TIME_INPUT].getChannels(), inputs[GATE_LENGTH_INPUT].getChannels(), inputs[TRIGGER_PLAY_INPUT].getChannels() });
+		const auto playTriggerInputConnected = inputs[TRIGGER_PLAY_INPUT].isConnected();
+
+		const auto now = clock++;
+		const auto capacity = queueCapacity;
+
+		outputs[TRIGGER_OUTPUT].setChannels(channels);
+
+		for (int c = 0; c < channels; c += 4)
 		{
-			auto gateDuration = params[GATE_LENGTH_PARAM].getValue();
-			if (inputs[GATE_LENGTH_INPUT].isConnected())
-				gateDuration = clamp(gateDuration * exp2f(inputs[GATE_LENGTH_INPUT].getVoltage()), 1e-3f, 5.f);
+			const auto lanes = std::min(channels - c, 4);
+			const auto laneBits = (1 << lanes) - 1;
+			auto pending = pendingTriggers + c;
+
+			// unpatched, each channel schedules its next delay as soon as the last one has elapsed
+			int playTriggered = 0;
+			simd::float_4 elapsed = 0.f;
+			if (playTriggerInputConnected)
+			{
+				playTriggered = simd::movemask(triggerPlay[c / 4].process((inputs[TRIGGER_PLAY_INPUT].getPolyVoltageSimd<simd::float_4>(c) - 0.1f) / (2.f - 0.1f))) & laneBits;
+				elapsed = triggerPlay[c / 4].elapsed;
+			}
+			else
+				for (int i = 0; i < lanes; ++i)
+					playTriggered |= pending[i].empty() << i;
 
-			pulseGenerator.trigger(gateDuration);
-		}
+			if (playTriggered)
+			{
+				simd::float_4 delayTime = params[DELAY_TIME_PARAM].getValue();
+				if (inputs[DELAY_TIME_INPUT].isConnected())
+					delayTime = simd::fmin(delayTime * math::fastExp2(inputs[DELAY_TIME_INPUT].getPolyVoltageSimd<simd::float_4>(c)), 5.f);
+
+				// the delay is counted from the sample the trigger arrived in, which is its first, less the part of a sample
+				// since the trigger's edge; a delay can't fall due before the sample it was scheduled in
+				const auto delaySamples = math::toSamples(delayTime, args.sampleRate);
+				const simd::int32_4 early = elapsed * (1 << subSampleBits) + 0.5f;
+				for (int i = 0; i < lanes; ++i)
+					if (playTriggered & (1 << i))
+					{
+						const auto due = std::max(((now + std::max(delaySamples[i] - 1, 0)) << subSampleBits) - early[i], now << subSampleBits);
+						if (!pending[i].push(due, capacity))
+							++droppedTriggers;
+					}
+			}
 
-		outputs[TRIGGER_OUTPUT].setVoltage(pulseGenerator.process(args.sampleTime) * 10.f);
+			// a gate whose edge falls between samples starts in the sample before it, at the fraction of the level it
+			// covers, as if sampled from a continuous gate
+			int delayedLanes = 0;
+			simd::float_4 edgeLevel = 1.f;
+			for (int i = 0; i < lanes; ++i)
+			{
+				if (pending[i].empty() || (pending[i].front() >> subSampleBits) > now)
+					continue;
+
+				const auto fraction = pending[i].front() & ((1 << subSampleBits) - 1);
+				edgeLevel[i] = 1.f - static_cast<float>(fraction) / (1 << subSampleBits);
+
+				// delays that fell due together make a single gate
+				while (!pending[i].empty() && (pending[i].front() >> subSampleBits) <= now)
+					pending[i].pop();
+
+				delayedLanes |= 1 << i;
+			}
+
+			if (delayedLanes)
+			{
+				const auto delayed = math::laneMask(delayedLanes);
+
+				simd::float_4 gateDuration = params[GATE_LENGTH_PARAM].getValue();
+				if (inputs[GATE_LENGTH_INPUT].isConnected())
+					gateDuration = simd::clamp(gateDuration * math::fastExp2(inputs[GATE_LENGTH_INPUT].getPolyVoltageSimd<simd::float_4>(c)), 1e-3f, 5.f);
+
+				// gates already high keep their level
+				edgeLevel = simd::ifelse(pulseGenerator[c / 4].isActive(), simd::float_4(1.f), edgeLevel);
+				pulseGenerator[c / 4].trigger(delayed, math::toSamples(gateDuration, args.sampleRate));
+			}
+
+			outputs[TRIGGER_OUTPUT].setVoltageSimd(pulseGenerator[c / 4].process() & (edgeLevel * 10.f), c);
+		}
 	}
 
 	struct Widget : gui::BaseModuleWidget
@@ -170,6 +277,56 @@ struct DTrig : Module
 			ModuleWidget::draw(args);
 		}
 
+		using BasicMenuItem = gui::BasicMenuItem<MyModule>;
+
+		struct QueueCapacitySubmenuItem : BasicMenuItem
+		{
+			Menu* createChildMenu() override
+			{
+				struct QueueCapacityItem : BasicMenuItem
+				{
+					QueueCapacityItem(int queueCapacity) : queueCapacity(queueCapacity) {}
+
+					int queueCapacity{};
+					void onAction(const event::Action& e) override
+					{
+						module->queueCapacity = queueCapacity;
+					}
+				};
+
+				Menu* menu = new Menu;
+				for (auto queueCapacity = 1; queueCapacity <= maxQueueCapacity; queueCapacity *= 2)
+					menu->addChild(createMenuItem<QueueCapacityItem>(module, std::to_string(queueCapacity), CHECKMARK(module->queueCapacity == queueCapacity), queueCapacity));
+				return menu;
+			}
+
+			static MenuItem* create(MyModule* module)
+			{
+				return createMenuItem<QueueCapacitySubmenuItem>(module, "Pending triggers per channel:", std::to_string(module->queueCapacity) + "  " + RIGHT_ARROW);
+			}
+		};
+
+		// shows how many triggers found their channel's queue full; clicking clears the count
+		struct DroppedTriggersItem : BasicMenuItem
+		{
+			void onAction(const event::Action& e) override
+			{
+				module->droppedTriggers = 0;
+			}
+
+			static MenuItem* create(MyModule* module)
+			{
+				return createMenuItem<DroppedTriggersItem>(module, "Dropped triggers (click to clear)", std::to_string(module->droppedTriggers));
+			}
+		};
+
+		void appendContextMenu(Menu* menu) override
+		{
+			menu->addChild(new MenuSeparator);
+			menu->addChild(QueueCapacitySubmenuItem::create(dynamic_cast<MyModule*>(module)));
+			menu->addChild(DroppedTriggersItem::create(dynamic_cast<MyModule*>(module)));
+		}
+
 		NVGcolor getBackgroundFillColor() override { return nvgRGBA(0xb4, 0xb4, 0xc6, 0x1a); }
 		NVGcolor getBackgroundStrokeColor() override { return nvgRGBA(0x7b, 0xc6, 0xc6, 0x7f); }
 	};
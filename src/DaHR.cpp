@@ -0,0 +1,210 @@
+#include "plugin.hpp"
+#include "DA.hpp"
+
+namespace DigitalAtavism {
+
+struct HR : Module
+{
+	enum ParamIds
+	{
+		HOLD_TIME_PARAM,
+		RELEASE_TIME_PARAM,
+		PUNCH_PARAM,
+		NUM_PARAMS
+	};
+	enum InputIds
+	{
+		HOLD_TIME_INPUT,
+		RELEASE_TIME_INPUT,
+		PUNCH_INPUT,
+		TRIGGER_PLAY_INPUT,
+		NUM_INPUTS
+	};
+	enum OutputIds
+	{
+		ENV_OUTPUT,
+		NUM_OUTPUTS
+	};
+	enum LightIds
+	{
+		NUM_LIGHTS
+	};
+
+	HR()
+	{
+		INFO("DigitalAtavism - HR: %i params  %i inputs  %i outputs  %i lights", NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+
+		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+		configParam(HOLD_TIME_PARAM, 0.001f, 2, 0.05f, "Hold Time", " ms", 0, 1000);
+		configParam(RELEASE_TIME_PARAM, 0, 2, 0.25f, "Release Time", " ms", 0, 1000);
+		configParam(PUNCH_PARAM, 0, 1, 0, "Punch", "%", 0, 100);
+
+		configInput(HOLD_TIME_INPUT, "Hold time");
+		configInput(RELEASE_TIME_INPUT, "Release time");
+		configInput(PUNCH_INPUT, "Punch");
+		configInput(TRIGGER_PLAY_INPUT, "Trigger");
+
+		configOutput(ENV_OUTPUT, "Envelope");
+
+		onReset();
+	}
+
+	dsp::TSubSampleTrigger<simd::float_4> triggerPlay[PORT_MAX_CHANNELS / 4];
+	dsp::HrEnvelopeBank<PORT_MAX_CHANNELS> envelopes;
+	// volts per unit of each envelope, lowered by its punch so that its peak is still 10V
+	simd::float_4 outputScale[PORT_MAX_CHANNELS / 4];
+
+	void onReset() override
+	{
+		for (auto& trigger : triggerPlay)
+			trigger.reset();
+
+		for (auto& scale : outputScale)
+			scale = 10.f;
+
+		envelopes.stop();
+	}
+
+	void process(const ProcessArgs &args) override
+	{
+		const auto channels = std::max({ 1, inputs[HOLD_TIME_INPUT].getChannels(), inputs[RELEASE_TIME_INPUT].getChannels(), inputs[PUNCH_INPUT].getChannels(),
+			inputs[TRIGGER_PLAY_INPUT].getChannels() });
+		const auto playTriggerInputConnected = inputs[TRIGGER_PLAY_INPUT].isConnected();
+
+		outputs[ENV_OUTPUT].setChannels(channels);
+
+		for (int c = 0; c < channels; c += 4)
+		{
+			const auto laneBits = (1 << std::min(channels - c, 4)) - 1;
+
+			// unpatched, each envelope restarts as soon as it ends
+			const auto playTriggered = playTriggerInputConnected
+				? triggerPlay[c / 4].process((inputs[TRIGGER_PLAY_INPUT].getPolyVoltageSimd<simd::float_4>(c) - 0.1f) / (2.f - 0.1f))
+				: ~envelopes.isActive(c / 4);
+
+			// the times and punch are only read when an envelope starts
+			if (simd::movemask(playTriggered) & laneBits)
+			{
+				simd::float_4 holdTime = params[HOLD_TIME_PARAM].getValue();
+				if (inputs[HOLD_TIME_INPUT].isConnected())
+					holdTime = simd::clamp(holdTime * math::fastExp2(inputs[HOLD_TIME_INPUT].getPolyVoltageSimd<simd::float_4>(c)), 0.0005f, 10.f);
+
+				simd::float_4 releaseTime = params[RELEASE_TIME_PARAM].getValue();
+				if (inputs[RELEASE_TIME_INPUT].isConnected())
+					releaseTime = simd::fmin(simd::fmax(releaseTime, 0.00001f) * math::fastExp2(inputs[RELEASE_TIME_INPUT].getPolyVoltageSimd<simd::float_4>(c)), 10.f);
+
+				const auto punchAmount = simd::clamp(params[PUNCH_PARAM].getValue() + inputs[PUNCH_INPUT].getPolyVoltageSimd<simd::float_4>(c) * 0.1f, 0.f, 1.f);
+
+				envelopes.start(c / 4, playTriggered, args.sampleRate, holdTime, releaseTime, punchAmount,
+					playTriggerInputConnected ? triggerPlay[c / 4].elapsed : simd::float_4::zero());
+
+				// the punch starts the hold stage at 1 + 2 * punchAmount
+				outputScale[c / 4] = simd::ifelse(playTriggered, 10.f / (1.f + 2.f * punchAmount), outputScale[c / 4]);
+			}
+
+			outputs[ENV_OUTPUT].setVoltageSimd(envelopes.process(c / 4) * outputScale[c / 4], c);
+		}
+	}
+
+	struct Widget : gui::BaseModuleWidget
+	{
+		using MyModule = HR;
+
+		Widget(MyModule* module)
+		{
+			setModule(module);
+
+			box.size = Vec(RACK_GRID_WIDTH * 5, RACK_GRID_HEIGHT);
+
+			addName("hr", "DA");
+
+			addChild(createWidget<ScrewBlack>(Vec(RACK_GRID_WIDTH, 0)));
+			addChild(createWidget<ScrewBlack>(Vec(RACK_GRID_WIDTH * 2, RACK_GRID_HEIGHT - RACK_GRID_WIDTH)));
+
+			addChild(createWidget<ScrewSilver>(Vec(box.size.x - 5 * RACK_GRID_WIDTH / 4, RACK_GRID_WIDTH * 3)));
+			addChild(createWidget<ScrewSilver>(Vec(RACK_GRID_WIDTH / 4, RACK_GRID_HEIGHT - RACK_GRID_WIDTH * 4)));
+			addChild(createWidget<ScrewSilver>(Vec(RACK_GRID_WIDTH / 4, RACK_GRID_WIDTH * 3)));
+
+			// knobs on the left, their CV inputs on the right
+			const auto xLeft = RACK_GRID_WIDTH * 1.25f;
+			const auto xRight = box.size.x - RACK_GRID_WIDTH * 1.25f;
+			const auto xCenter = box.size.x / 2;
+			auto yPos = RACK_GRID_WIDTH * 6.25f;
+
+			addChild(new gui::TextLabel<NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE>(xCenter, yPos - RACK_GRID_WIDTH * 5 / 4, "HOLD", smallFontSize, smallFontDark, smallFont));
+			addParam(createParamCentered<RoundSmallBlackKnob>(Vec(xLeft, yPos), module, HOLD_TIME_PARAM));
+			addInput(createInputCentered<PJ301MPort>(Vec(xRight, yPos), module, HOLD_TIME_INPUT));
+
+			yPos += RACK_GRID_WIDTH * 3.25f;
+			addChild(new gui::TextLabel<NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE>(xCenter, yPos - RACK_GRID_WIDTH * 5 / 4, "REL", smallFontSize, smallFontDark, smallFont));
+			addParam(createParamCentered<RoundSmallBlackKnob>(Vec(xLeft, yPos), module, RELEASE_TIME_PARAM));
+			addInput(createInputCentered<PJ301MPort>(Vec(xRight, yPos), module, RELEASE_TIME_INPUT));
+
+			yPos += RACK_GRID_WIDTH * 3.25f;
+			addChild(new gui::TextLabel<NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE>(xCenter, yPos - RACK_GRID_WIDTH * 5 / 4, "PUNCH", smallFontSize, smallFontDark, smallFont));
+			addParam(createParamCentered<RoundSmallBlackKnob>(Vec(xLeft, yPos), module, PUNCH_PARAM));
+			addInput(createInputCentered<PJ301MPort>(Vec(xRight, yPos), module, PUNCH_INPUT));
+
+			yPos += RACK_GRID_WIDTH * 3.75f;
+			addChild(new gui::TextLabel<NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE>(xCenter, yPos - RACK_GRID_WIDTH * 5 / 4, "TRIG", smallFontSize, smallFontDark, smallFont));
+			addInput(createInputCentered<PJ301MPort>(Vec(xCenter, yPos), module, TRIGGER_PLAY_INPUT));
+
+			yPos += RACK_GRID_WIDTH * 3.25f;
+			addChild(new gui::TextLabel<NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE>(xCenter, yPos - RACK_GRID_WIDTH * 5 / 4, "ENV", smallFontSize, smallFontLight, smallFont));
+			addOutput(createOutputCentered<PJ301MPort>(Vec(xCenter, yPos), module, ENV_OUTPUT));
+		}
+
+		void draw(const DrawArgs& args) override
+		{
+			{
+				nvgStrokeColor(args.vg, nvgRGB(0, 0, 0));
+				nvgFillColor(args.vg, nvgRGB(0xc9, 0xc9, 0xc9));
+				nvgStrokeWidth(args.vg, 1);
+				nvgBeginPath(args.vg);
+				nvgRect(args.vg, RACK_GRID_WIDTH / 4, RACK_GRID_WIDTH * 3, box.size.x - RACK_GRID_WIDTH / 2, box.size.y - RACK_GRID_WIDTH * 6);
+				nvgStroke(args.vg);
+				nvgFill(args.vg);
+			}
+
+			{
+				nvgStrokeColor(args.vg, getBackgroundStrokeColor());
+				nvgFillColor(args.vg, getBackgroundFillColor());
+				nvgStrokeWidth(args.vg, 1);
+				nvgBeginPath(args.vg);
+				nvgRoundedRect(args.vg, 1, 1, box.size.x - 2, box.size.y - 2, 5);
+				nvgStroke(args.vg);
+				nvgFill(args.vg);
+			}
+
+			{
+				nvgStrokeColor(args.vg, nvgRGB(54, 54, 54));
+				nvgFillColor(args.vg, nvgRGB(189, 189, 189));
+				nvgStrokeWidth(args.vg, 1);
+				nvgBeginPath(args.vg);
+				nvgRoundedRect(args.vg, RACK_GRID_WIDTH * 0.5f, RACK_GRID_WIDTH * 4.5f, box.size.x - RACK_GRID_WIDTH, RACK_GRID_WIDTH * 9.75f, 5);
+				nvgRoundedRect(args.vg, RACK_GRID_WIDTH * 1, RACK_GRID_WIDTH * 14.75f, box.size.x - RACK_GRID_WIDTH * 2, RACK_GRID_WIDTH * 3, 5);
+				nvgStroke(args.vg);
+				nvgFill(args.vg);
+			}
+
+			{
+				nvgStrokeColor(args.vg, nvgRGB(54, 54, 54));
+				nvgFillColor(args.vg, nvgRGB(115, 115, 115));
+				nvgStrokeWidth(args.vg, 1);
+				nvgBeginPath(args.vg);
+				nvgRoundedRect(args.vg, RACK_GRID_WIDTH * 1, RACK_GRID_WIDTH * 18.f, box.size.x - RACK_GRID_WIDTH * 2, RACK_GRID_WIDTH * 3, 5);
+				nvgStroke(args.vg);
+				nvgFill(args.vg);
+			}
+
+			ModuleWidget::draw(args);
+		}
+
+		NVGcolor getBackgroundFillColor() override { return nvgRGBA(0xc6, 0xb4, 0xb4, 0x1a); }
+		NVGcolor getBackgroundStrokeColor() override { return nvgRGBA(0xc6, 0x7b, 0x7b, 0x7f); }
+	};
+};
+
+} // namespace DigitalAtavism
+
+Model* modelHR = DigitalAtavism::createDaModel<DigitalAtavism::HR>("HR");
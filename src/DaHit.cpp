@@ -1,8 +1,8 @@
-#include "DA.hpp"
+#include "DaSfxr.hpp"
 
 namespace DigitalAtavism {
 
-struct Hit : Module
+struct Hit : SfxrBase
 {
 	enum ParamIds
 	{
@@ -74,108 +74,169 @@ struct Hit : Module
 		onReset();
 	}
 
-	struct Osc
+	// hands out the module's noise, refilled from its generator a block at a time
+	struct Noise
 	{
-		enum { supersampling = 8, }; // could go down to 1, if required...
+		enum { size = 64 };
 
-		int phase{};
+		math::Random& random;
+		float values[size]{};
+		int index{ size };
 
-		float fperiod{ 1.f };
-		float fslide{ 1.f };
+		explicit Noise(math::Random& random) : random(random) {}
 
-		enum { noise_buffer_size = 32 };
-		int noise_buffer_index{ -1 };
-		float noise_value{};
+		void reset()
+		{
+			index = size;
+		}
+
+		float next()
+		{
+			if (index == size)
+			{
+				random.fill(values, size);
+				index = 0;
+			}
 
-		float fltp{};
-		float fltdp{};
-		float fltw{ 0.1f };
-		float flthp{};
-		float fltphp{};
+			return values[index++] - 0.5f;
+		}
+	};
 
-		void resetPhase()
+	struct Osc
+	{
+		simd::int32_4 phase = 0;
+
+		simd::float_4 fperiod = 1.f;
+		simd::float_4 fslide = 1.f;
+
+		enum { noise_buffer_size = 32 };
+		static_assert(noise_buffer_size == 1 << 5, "process() multiplies by noise_buffer_size with a shift");
+		simd::int32_4 noise_buffer_index = -1;
+		simd::float_4 noise_value = 0.f;
+
+		simd::float_4 fltp = 0.f;
+		simd::float_4 fltdp = 0.f;
+		simd::float_4 fltw = 0.1f;
+		simd::float_4 fltdmp = 5.0f / (1.0f + da::math::sqr(0.4f * 0.1f) * 20.0f) * (0.04f + 0.1f);
+		simd::float_4 flthp = 0.f;
+
+		// the weights of the waveforms mixed by the wave type, with the square's two levels prescaled
+		simd::float_4 square_high = 0.5f;
+		simd::float_4 square_low = -0.5f;
+		simd::float_4 sawtooth_gain = 0.f;
+		simd::float_4 noise_gain = 0.f;
+		simd::float_4 fltphp = 0.f;
+
+		// restarts the cycle as if it had begun elapsed samples ago; process() wraps it into the period
+		template<int supersampling>
+		void resetPhase(simd::float_4 mask, simd::float_4 elapsed)
 		{
-			phase = 0;
+			phase = simd::ifelse(simd::int32_4::cast(mask), simd::int32_4(elapsed * supersampling + 0.5f), phase);
 		}
 
-		void resetFilter()
+		void resetFilter(simd::float_4 mask)
 		{
-			fltp = fltdp = fltphp = 0.f;
+			fltp = simd::ifelse(mask, simd::float_4::zero(), fltp);
+			fltdp = simd::ifelse(mask, simd::float_4::zero(), fltdp);
+			fltphp = simd::ifelse(mask, simd::float_4::zero(), fltphp);
 		}
 
-		float getNoise() const
+		void setOscPeriod(simd::float_4 mask, float sampleRate, simd::float_4 oscPeriod)
 		{
-			return da::math::frnd() - 0.5f;
+			fperiod = simd::ifelse(mask, oscPeriod * sampleRate, fperiod);
 		}
 
-		void setOscPeriod(float sampleRate, float oscPeriod)
+		void scalePeriod(simd::float_4 ratio)
 		{
-			fperiod = oscPeriod * sampleRate;
+			fperiod *= ratio;
 		}
 
-		void setLoPassFilter(float value)
+		void rescale(int fromSupersampling, int toSupersampling)
+		{
+			fperiod *= static_cast<float>(toSupersampling) / fromSupersampling;
+			for (int i = 0; i < 4; ++i)
+				phase[i] = phase[i] * toSupersampling / fromSupersampling;
+		}
+
+		void setLoPassFilter(simd::float_4 mask, float value)
 		{
 			value *= 0.9f;
 			value += 0.1f;
-			fltw = value * value * value * 0.1f;
+			fltw = simd::ifelse(mask, simd::float_4(value * value * value * 0.1f), fltw);
+			fltdmp = 5.0f / (1.0f + da::math::sqr(0.4f * fltw) * 20.0f) * (0.04f + fltw);
+			//if (fltdmp > 0.8f) fltdmp = 0.8f;
 		}
 
-		void setHiPassFilter(float value)
+		void setHiPassFilter(simd::float_4 mask, float value)
 		{
-			flthp = da::math::sqr(value) * 0.1f;
+			flthp = simd::ifelse(mask, simd::float_4(da::math::sqr(value) * 0.1f), flthp);
 		}
 
-		void setFreqSlide(float value)
+		void setFreqSlide(simd::float_4 mask, simd::float_4 value)
 		{
-			fslide = 1.f + value * value * value * 0.01f;
+			fslide = simd::ifelse(mask, 1.f + value * value * value * 0.01f, fslide);
 		}
 
-		float process(float wave_type, float square_duty)
+		// wave_type crossfades square to sawtooth over [0, 1], sawtooth to noise over [1, 2] and noise back to square over [2, 3]
+		void setWaveType(simd::float_4 wave_type)
 		{
-			float ret{};
+			const auto first = wave_type <= 1.0f;
+			const auto second = wave_type <= 2.0f;
+			const auto square_gain = simd::ifelse(first, 1.0f - wave_type, simd::ifelse(second, simd::float_4::zero(), wave_type - 2.0f));
+			square_high = square_gain * 0.5f;
+			square_low = square_gain * -0.5f;
+			sawtooth_gain = simd::ifelse(first, wave_type, simd::ifelse(second, 2.0f - wave_type, simd::float_4::zero()));
+			noise_gain = simd::ifelse(first, simd::float_4::zero(), simd::ifelse(second, wave_type - 1.0f, 3.0f - wave_type));
+		}
+
+		// lanes selects the channels that draw noise, so that unused lanes leave the random sequence alone
+		template<int supersampling>
+		simd::float_4 process(simd::float_4 square_duty, int lanes, Noise& noise)
+		{
+			simd::float_4 ret = 0.f;
 
 			fperiod *= fslide;
 
-			int period = (int)fperiod;
-			if (period < supersampling)
-			{
-				fperiod = (period = supersampling);
-				fslide = 1.0f;
-			}
-			else if (period > 50000 * supersampling)
-			{
-				fperiod = (period = 50000 * supersampling);
-				fslide = 1.0f;
-			}
+			simd::int32_4 period = fperiod;
+			const auto tooShort = period < simd::int32_4(supersampling);
+			const auto tooLong = period > simd::int32_4(50000 * supersampling);
+			period = simd::ifelse(tooShort, simd::int32_4(supersampling), simd::ifelse(tooLong, simd::int32_4(50000 * supersampling), period));
+			const auto clamped = simd::float_4::cast(tooShort | tooLong);
+			fperiod = simd::ifelse(clamped, simd::float_4(period), fperiod);
+			fslide = simd::ifelse(clamped, simd::float_4(1.0f), fslide);
+
+			// the slide can shorten the period below the phase, which the loop below expects to wrap at most once
+			if (simd::movemask(phase >= period))
+				for (int i = 0; i < 4; ++i)
+					phase[i] %= period[i];
 
-			const int duty = (int)(square_duty * period);
+			const simd::float_4 speriod = period;
+			const simd::int32_4 duty = square_duty * speriod;
 
 			for (int i = 0; i < supersampling; ++i)
 			{
-				++phase;
-				phase %= period;
+				phase += 1;
+				phase = simd::ifelse(phase >= period, simd::int32_4::zero(), phase);
 
 				// base waveform
-				const float fp = (float)phase / period;
-				const auto square = phase <= duty ? 0.5f : -0.5f;
+				const auto fp = simd::float_4(phase) / speriod;
+				const auto square = simd::ifelse(simd::float_4::cast(phase <= duty), square_high, square_low);
 				const auto sawtooth = 1.0f - fp * 2;
 
+				// the float quotient truncates like the integer one: it is below noise_buffer_size, so it is rounded by
+				// at most 2^-20, less than the 1 / period a fractional quotient lies from an integer while period < 2^20
 				const auto previous_noise_buffer_index = noise_buffer_index;
-				noise_buffer_index = phase * noise_buffer_size / period;
-				if (previous_noise_buffer_index != noise_buffer_index)
-					noise_value = getNoise();
+				noise_buffer_index = simd::float_4(phase << 5) / speriod;
+				if (const auto changed = simd::movemask(simd::float_4::cast(noise_buffer_index != previous_noise_buffer_index)) & ((1 << lanes) - 1))
+					for (int j = 0; j < 4; ++j)
+						if (changed & (1 << j))
+							noise_value[j] = noise.next();
 
-				const auto noise = noise_value;
-				const auto sample = wave_type <= 1.0f ? 
-					(1.0f - wave_type) * square + sawtooth * wave_type : 
-					wave_type <= 2.0f ? (2.0f - wave_type) * sawtooth + noise * (wave_type - 1.0f) :
-					(3.0f - wave_type) * noise + square * (wave_type - 2.0f);
+				const auto sample = square + sawtooth * sawtooth_gain + noise_value * noise_gain;
 
 				// lp filter
 				const auto pp = fltp;
 				fltdp += (sample - fltp) * fltw;
-				const float fltdmp = 5.0f / (1.0f + da::math::sqr(0.4f * fltw) * 20.0f) * (0.04f + fltw);
-				//if (fltdmp > 0.8f) fltdmp = 0.8f;
 				fltdp -= fltdp * fltdmp;
 				fltp += fltdp;
 
@@ -190,87 +251,300 @@ struct Hit : Module
 		}
 	};
 
-	rack::dsp::SchmittTrigger triggerPlay;
+	// voice state for four channels, so that up to 16 voices are processed in four SIMD passes
+	struct Voices
+	{
+		Osc osc;
+
+		// the pitch the period was last tracked to
+		simd::float_4 pitch = 0.f;
 
-	Osc osc;
-	dsp::HrEnvelope envelope;
+		// the outputs of the last rendered block
+		simd::float_4 mainFrames[maxBlockSize]{};
+		simd::float_4 envFrames[maxBlockSize]{};
+
+		// the outputs rendered at the render rate
+		Resampler mainResampler;
+		Resampler envResampler;
+
+		dsp::TRateReducer<simd::float_4> rateReducer;
+
+		void reset()
+		{
+			mainResampler.reset();
+			envResampler.reset();
+			rateReducer.reset();
+		}
+	};
+
+	Voices voices[PORT_MAX_CHANNELS / 4];
+	// the voices' volume envelopes, one vector per group
+	dsp::HrEnvelopeBank<PORT_MAX_CHANNELS> envelopes;
+	Noise noise{ random };
 
 	void onReset() override
 	{
 		onSampleRateChange();
 
-		triggerPlay.reset();
+		resetRendering();
+		for (auto& voice : voices)
+			voice.reset();
+		envelopes.stop();
 
-		envelope.stop();
 		onRandomize();
 	}
 
+	void dataFromJson(json_t* rootJ) override
+	{
+		SfxrBase::dataFromJson(rootJ);
+
+		// start over from the saved seed
+		noise.reset();
+	}
+
 	void onRandomize() override
 	{
 		const auto timeRatio = 1.0f / 44100.0f;
 
-		const auto period = 100.0f / (da::math::sqr(0.2f + da::math::frnd() * 0.6f) + 0.001f) * timeRatio;
-		params[FREQ_PARAM].setValue(log2f(osc.supersampling / rack::dsp::FREQ_C4 / period) * 12.0f);
-
-		const auto waveType = da::math::rnd<2>();
+		const auto period = 100.0f / (da::math::sqr(0.2f + da::math::frnd(random) * 0.6f) + 0.001f) * timeRatio;
+		params[FREQ_PARAM].setValue(log2f(sfxrSupersampling / rack::dsp::FREQ_C4 / period) * 12.0f);
+		const auto waveType = da::math::rnd<2>(random);
 		params[TYPE_SELECTION_PARAM].setValue(waveType);
 
-		const auto squareDuty = da::math::frnd() * 0.6f;
+		const auto squareDuty = da::math::frnd(random) * 0.6f;
 		params[SQUARE_DUTY_PARAM].setValue(squareDuty);
 
-		const auto holdTime = da::math::sqr(da::math::frnd() * 0.1f) * 100000.0f * timeRatio;
+		const auto holdTime = da::math::sqr(da::math::frnd(random) * 0.1f) * 100000.0f * timeRatio;
 		params[HOLD_TIME_PARAM].setValue(holdTime);
 
-		const auto releaseTime = da::math::sqr(0.1f + da::math::frnd() * 0.2f) * 100000.0f * timeRatio;
+		const auto releaseTime = da::math::sqr(0.1f + da::math::frnd(random) * 0.2f) * 100000.0f * timeRatio;
 		params[RELEASE_TIME_PARAM].setValue(releaseTime);
 
-		params[FREQ_SLIDE_PARAM].setValue(0.3f + da::math::frnd() * 0.4f);
+		params[FREQ_SLIDE_PARAM].setValue(0.3f + da::math::frnd(random) * 0.4f);
 
-		params[HIPASS_FILTER_PARAM].setValue(da::math::rnd<1>() ? da::math::frnd() * 0.3f : 0.0f);
+		params[HIPASS_FILTER_PARAM].setValue(da::math::rnd<1>(random) ? da::math::frnd(random) * 0.3f : 0.0f);
 
-		params[LOPASS_FILTER_PARAM].setValue(0.6f + da::math::frnd() * 0.4f);
+		params[LOPASS_FILTER_PARAM].setValue(0.6f + da::math::frnd(random) * 0.4f);
 	}
 
 	void process(const ProcessArgs &args) override
 	{
-		const auto playTriggerInputConnected = inputs[TRIGGER_PLAY_INPUT].isConnected();
-		const auto playTriggered = triggerPlay.process(playTriggerInputConnected ? rescale(inputs[TRIGGER_PLAY_INPUT].getVoltage(), 0.1f, 2.f, 0.f, 1.f) : 0.f);
+		const auto channels = std::max({ 1, inputs[PITCH_INPUT].getChannels(), inputs[FREQ_SLIDE_INPUT].getChannels(), inputs[BLEND_INPUT].getChannels(),
+			inputs[SQUARE_DUTY_INPUT].getChannels(), inputs[HOLD_TIME_INPUT].getChannels(), inputs[RELEASE_TIME_INPUT].getChannels(), inputs[TRIGGER_PLAY_INPUT].getChannels() });
+
+		if (captureFrame(inputs[TRIGGER_PLAY_INPUT], inputs[PITCH_INPUT], channels))
+		{
+			const auto requestedSupersampling = supersampling;
+			if (requestedSupersampling != renderedSupersampling)
+			{
+				for (auto& voice : voices)
+					voice.osc.rescale(renderedSupersampling, requestedSupersampling);
+
+				renderedSupersampling = requestedSupersampling;
+			}
 
-		if (playTriggered || !playTriggerInputConnected)
+			switch (renderedSupersampling)
+			{
+			case 1: renderBlock<1>(args, channels); break;
+			case 2: renderBlock<2>(args, channels); break;
+			case 4: renderBlock<4>(args, channels); break;
+			case 8: renderBlock<8>(args, channels); break;
+			case 16: renderBlock<16>(args, channels); break;
+			}
+
+			startBlock(channels);
+		}
+
+		const auto frame = getOutputFrame();
+
+		outputs[VOLUME_ENV_OUTPUT].setChannels(block.renderedChannels);
+		outputs[MAIN_OUTPUT].setChannels(block.renderedChannels);
+
+		for (int c = 0; c < block.renderedChannels; c += 4)
 		{
-			const auto oscPeriod = osc.supersampling / rack::dsp::FREQ_C4 * exp2f(-params[FREQ_PARAM].getValue() / 12.0f - inputs[PITCH_INPUT].getVoltage());
-			osc.setOscPeriod(args.sampleRate, oscPeriod);
-			osc.setLoPassFilter(params[LOPASS_FILTER_PARAM].getValue());
-			osc.setHiPassFilter(params[HIPASS_FILTER_PARAM].getValue());
+			const auto& voice = voices[c / 4];
+			outputs[MAIN_OUTPUT].setVoltageSimd(voice.mainFrames[frame], c);
+			outputs[VOLUME_ENV_OUTPUT].setVoltageSimd(voice.envFrames[frame], c);
 		}
+	}
+
+	template<int oscSupersampling>
+	void renderBlock(const ProcessArgs &args, int channels)
+	{
+		const auto sampleRate = scheduleBlock(args.sampleRate);
+		const auto mainBitDepth = bitDepth;
+		const auto quantizeMain = getQuantizeKernel(mainBitDepth);
+		const auto mainRateReduction = rateReduction;
+		if (resampling.active && resampling.restarted)
+			for (auto& voice : voices)
+			{
+				voice.mainResampler.reset();
+				voice.envResampler.reset();
+			}
+
+		const auto playTriggerInputConnected = inputs[TRIGGER_PLAY_INPUT].isConnected();
+		const auto frequency = params[FREQ_PARAM].getValue();
 
-		if (playTriggered)
+		// unpatched outputs are not rendered; the envelope always runs, as it decides when voices go idle
+		const auto mainConnected = outputs[MAIN_OUTPUT].isConnected();
+		const auto envConnected = outputs[VOLUME_ENV_OUTPUT].isConnected();
+		const auto connectedOutputs = static_cast<float>(mainConnected | envConnected << 1);
+
+		const auto caching = startCaching(playTriggerInputConnected);
+
+		for (int c = 0; c < channels; c += 4)
 		{
-			osc.resetPhase();
-			osc.resetFilter();
-			osc.setFreqSlide(clamp(-params[FREQ_SLIDE_PARAM].getValue() - inputs[FREQ_SLIDE_INPUT].getVoltage() * 0.1f, -1.f, 1.f));
+			auto& voice = voices[c / 4];
+			const auto lanes = std::min(channels - c, 4);
+			const auto laneBits = (1 << lanes) - 1;
+			const auto anyPlayTriggered = block.findTrigger(0, c) < block.size;
+
+			// the values triggers start the voices with, read once per block
+			simd::float_4 oscPeriod = 1.f;
+			if (anyPlayTriggered || !playTriggerInputConnected)
+				oscPeriod = oscSupersampling / rack::dsp::FREQ_C4 * math::fastExp2(-frequency / 12.0f - inputs[PITCH_INPUT].getPolyVoltageSimd<simd::float_4>(c));
+
+			const auto loPassFilter = params[LOPASS_FILTER_PARAM].getValue();
+			const auto hiPassFilter = params[HIPASS_FILTER_PARAM].getValue();
+			const auto freqSlide = simd::clamp(-params[FREQ_SLIDE_PARAM].getValue() - inputs[FREQ_SLIDE_INPUT].getPolyVoltageSimd<simd::float_4>(c) * 0.1f, -1.f, 1.f);
+
+			simd::float_4 holdTime = params[HOLD_TIME_PARAM].getValue();
+			simd::float_4 releaseTime = params[RELEASE_TIME_PARAM].getValue();
+			if (anyPlayTriggered)
+			{
+				if (inputs[HOLD_TIME_INPUT].isConnected())
+					holdTime = simd::clamp(holdTime * math::fastExp2(inputs[HOLD_TIME_INPUT].getPolyVoltageSimd<simd::float_4>(c)), 0.0005f, 0.5f);
+
+				if (inputs[RELEASE_TIME_INPUT].isConnected())
+					releaseTime = simd::fmin(simd::fmax(releaseTime, 0.00001f) * math::fastExp2(inputs[RELEASE_TIME_INPUT].getPolyVoltageSimd<simd::float_4>(c)), 0.5f);
+			}
 
-			auto holdTime = params[HOLD_TIME_PARAM].getValue();
-			if (inputs[HOLD_TIME_INPUT].isConnected())
-				holdTime = clamp(holdTime * exp2f(inputs[HOLD_TIME_INPUT].getVoltage()), 0.0005f, 0.5f);
+			const auto wave_type = simd::clamp(params[TYPE_SELECTION_PARAM].getValue() + inputs[BLEND_INPUT].getPolyVoltageSimd<simd::float_4>(c) * 0.1f * 3.f, 0.f, 3.f);
+			voice.osc.setWaveType(wave_type);
+			const auto square_duty = simd::clamp(params[SQUARE_DUTY_PARAM].getValue() + inputs[SQUARE_DUTY_INPUT].getPolyVoltageSimd<simd::float_4>(c) * 0.1f, 0.01f, 0.99f);
 
-			auto releaseTime = params[RELEASE_TIME_PARAM].getValue();
-			if (inputs[RELEASE_TIME_INPUT].isConnected())
-				releaseTime = std::min(std::max(releaseTime, 0.00001f) * exp2f(inputs[RELEASE_TIME_INPUT].getVoltage()), 0.5f);
+			if (!playTriggerInputConnected)
+			{
+				voice.osc.setLoPassFilter(simd::float_4::mask(), loPassFilter);
+				voice.osc.setHiPassFilter(simd::float_4::mask(), hiPassFilter);
+			}
 
-			envelope.start(args.sampleRate, holdTime, releaseTime);
-		}
+			// renders one frame at sampleRate: the main and volume envelope outputs
+			auto renderFrame = [&](int frame, simd::float_4* values)
+			{
+				// triggered voices are silent between one-shots, and a trigger resets all the state they would advance,
+				// so idle groups skip the oscillator, filters and quantizer and output zeros
+				if (!playTriggerInputConnected || (simd::movemask(envelopes.isActive(c / 4)) & laneBits))
+				{
+					const auto env = envelopes.process(c / 4);
+
+					if (mainConnected)
+					{
+						// untriggered, the period is held rather than left to slide
+						if (!playTriggerInputConnected)
+						{
+							if (block.trackPitch)
+								oscPeriod = oscSupersampling / rack::dsp::FREQ_C4 * math::fastExp2(-frequency / 12.0f - block.pitch[frame][c / 4]);
+
+							voice.osc.setOscPeriod(simd::float_4::mask(), sampleRate, oscPeriod);
+						}
+						else if (block.trackPitch)
+						{
+							// pitch changes scale the sliding period, as fastExp2() leaves it untouched while the pitch holds
+							const auto pitch = block.pitch[frame][c / 4];
+							voice.osc.scalePeriod(math::fastExp2(voice.pitch - pitch));
+							voice.pitch = pitch;
+						}
+
+						const auto sample = voice.osc.process<oscSupersampling>(square_duty, lanes, noise);
+						const auto out = !playTriggerInputConnected ? sample : sample * env;
+						if (voice.rateReducer.advance(mainRateReduction))
+							voice.rateReducer.value = quantizeMain(out) * 5.0f;
+
+						values[0] = voice.rateReducer.value;
+					}
+
+					if (envConnected)
+						values[1] = quantize<8>(env) * 10.0f;
+				}
+				else
+					voice.rateReducer.reset();
+			};
 
-		const float wave_type = clamp(params[TYPE_SELECTION_PARAM].getValue() + inputs[BLEND_INPUT].getVoltage() * 0.1f * 3.f, 0.f, 3.f);
-		const float square_duty = clamp(params[SQUARE_DUTY_PARAM].getValue() + inputs[SQUARE_DUTY_INPUT].getVoltage() * 0.1f, 0.01f, 0.99f);
-		const auto sample = osc.process(wave_type, square_duty);
-		const auto env = envelope.process();
-		const auto out = !playTriggerInputConnected ? sample : sample * env;
-		outputs[MAIN_OUTPUT].setVoltage(quantize<8>(out) * 5.0f);
-		outputs[VOLUME_ENV_OUTPUT].setVoltage(quantize<8>(env) * 10.0f);
+			for (int frame = 0; frame < block.size;)
+			{
+				auto playTriggered = block.getTriggers(frame, c);
+				if (simd::movemask(playTriggered))
+				{
+					if (block.trackPitch)
+						oscPeriod = oscSupersampling / rack::dsp::FREQ_C4 * math::fastExp2(-frequency / 12.0f - block.pitch[frame][c / 4]);
+
+					// triggers rarely land on a sample: the oscillators and envelopes start as far along as the edge came early,
+					// rounded while caching to the steps that replayed one-shots match by their key
+					auto elapsed = block.elapsed[frame][c / 4] * (sampleRate / args.sampleRate);
+
+					if (caching)
+					{
+						elapsed = OneShotCache::quantizeElapsed(elapsed);
+						const auto replayed = startOneShots(c, lanes, playTriggered, [&](int i) {
+							return OneShotCache::Key{ args.sampleRate, sampleRate, static_cast<float>(oscSupersampling), oscPeriod[i], freqSlide[i], wave_type[i], square_duty[i],
+								holdTime[i], releaseTime[i], loPassFilter, hiPassFilter, static_cast<float>(mainBitDepth), static_cast<float>(mainRateReduction), connectedOutputs, elapsed[i] };
+						});
+						envelopes.stop(c / 4, replayed);
+						playTriggered = simd::andnot(replayed, playTriggered);
+					}
+
+					voice.osc.setOscPeriod(playTriggered, sampleRate, oscPeriod);
+					voice.osc.setLoPassFilter(playTriggered, loPassFilter);
+					voice.osc.setHiPassFilter(playTriggered, hiPassFilter);
+
+					voice.osc.resetPhase<oscSupersampling>(playTriggered, elapsed);
+					voice.osc.resetFilter(playTriggered);
+					voice.osc.setFreqSlide(playTriggered, freqSlide);
+
+					envelopes.start(c / 4, playTriggered, sampleRate, holdTime, releaseTime, 0.0f, elapsed);
+
+					if (block.trackPitch)
+						voice.pitch = simd::ifelse(playTriggered, block.pitch[frame][c / 4], voice.pitch);
+				}
+
+				// the frames up to the next trigger run without any per-sample bookkeeping
+				const auto end = block.findTrigger(frame + 1, c);
+				for (; frame < end; ++frame)
+				{
+					// the main and volume envelope outputs
+					simd::float_4 frameOutputs[2] = {};
+					const auto active = envelopes.isActive(c / 4);
+
+					if (!resampling.active)
+						renderFrame(frame, frameOutputs);
+					else
+					{
+						for (int step = 0; step < resampling.steps[frame]; ++step)
+						{
+							simd::float_4 rendered[2] = {};
+							renderFrame(frame, rendered);
+							voice.mainResampler.push(rendered[0]);
+							voice.envResampler.push(rendered[1]);
+						}
+
+						if (mainConnected)
+							frameOutputs[0] = voice.mainResampler.process(resampling.rows[frame]);
+						if (envConnected)
+							frameOutputs[1] = voice.envResampler.process(resampling.rows[frame]);
+					}
+
+					if (caching)
+						cacheFrame(c, lanes, ~active, frameOutputs, 2);
+
+					voice.mainFrames[frame] = frameOutputs[0];
+					voice.envFrames[frame] = frameOutputs[1];
+				}
+			}
+		}
 	}
 
-	struct Widget : gui::BaseModuleWidget
+	struct Widget : BaseWidget
 	{
 		using MyModule = Hit;
 
@@ -0,0 +1,736 @@
+#pragma once
+#include "DA.hpp"
+
+namespace DigitalAtavism {
+
+// one-shots rendered before, kept for triggers that repeat their parameters; the least recently used one makes room
+struct OneShotCache
+{
+	// a one-shot longer than maxFrames isn't cached, and plays live every time
+	enum { capacity = 16, maxKeySize = 15, maxFrames = 1 << 15, maxOutputs = 3 };
+
+	// cached one-shots start at whole 1 / elapsedSteps of a sample, so that triggers from an unsynced or slewed
+	// source still share entries
+	enum { elapsedSteps = 4 };
+
+	static simd::float_4 quantizeElapsed(simd::float_4 elapsed)
+	{
+		return simd::round(elapsed * elapsedSteps) / elapsedSteps;
+	}
+
+	// the effective parameters of a one-shot, compared by hash first
+	struct Key
+	{
+		float values[maxKeySize]{};
+		std::uint32_t hash{ 2166136261u };
+
+		Key() = default;
+
+		template<typename... Values>
+		Key(float first, Values... rest) : values{ first, static_cast<float>(rest)... }
+		{
+			static_assert(1 + sizeof...(rest) <= maxKeySize, "too many values for a key");
+
+			// FNV-1a over the bits of the values
+			const auto bytes = reinterpret_cast<const unsigned char*>(values);
+			for (size_t i = 0; i < sizeof(values); ++i)
+				hash = (hash ^ bytes[i]) * 16777619u;
+		}
+
+		bool operator==(const Key& other) const
+		{
+			return hash == other.hash && std::memcmp(values, other.values, sizeof(values)) == 0;
+		}
+	};
+
+	struct Entry
+	{
+		Key key;
+		// the outputs interleaved frame by frame, up to the frame the one-shot fell silent; reserved by allocate(), so
+		// that recording never allocates on the audio thread
+		std::vector<float> frames;
+		bool complete{};
+		// lanes replaying or recording the entry, which keep it from being evicted
+		int users{};
+		std::uint64_t lastUsed{};
+	};
+
+	Entry entries[capacity];
+	std::uint64_t clock{};
+
+	bool isAllocated() const
+	{
+		return entries[0].frames.capacity() != 0;
+	}
+
+	// reserves the frames of every entry; called outside the audio thread, before caching is turned on
+	void allocate()
+	{
+		for (auto& entry : entries)
+			entry.frames.reserve(maxFrames * maxOutputs);
+	}
+
+	// frees the frames of every entry and forgets the one-shots; called outside the audio thread, while nothing uses the cache
+	void free()
+	{
+		for (auto& entry : entries)
+		{
+			std::vector<float>().swap(entry.frames);
+			entry.complete = false;
+		}
+	}
+
+	// the complete entry for key, or null
+	Entry* find(const Key& key)
+	{
+		for (auto& entry : entries)
+			if (entry.complete && entry.key == key)
+			{
+				entry.lastUsed = ++clock;
+				return &entry;
+			}
+
+		return nullptr;
+	}
+
+	// an emptied entry to record key into, or null while key is already being recorded or every entry is in use
+	Entry* record(const Key& key)
+	{
+		Entry* oldest = nullptr;
+		for (auto& entry : entries)
+		{
+			if (!entry.complete && entry.users && entry.key == key)
+				return nullptr;
+
+			if (!entry.users && (!oldest || entry.lastUsed < oldest->lastUsed))
+				oldest = &entry;
+		}
+
+		if (oldest)
+		{
+			oldest->key = key;
+			oldest->frames.clear();
+			oldest->complete = false;
+			oldest->lastUsed = ++clock;
+		}
+
+		return oldest;
+	}
+
+	void clear()
+	{
+		for (auto& entry : entries)
+			if (!entry.users)
+				entry.complete = false;
+	}
+};
+
+// shared settings of the sfxr voices (coin, blip and hit)
+struct SfxrBase : Module
+{
+	// sfxr's own sub-step count, which the FREQ knob and onRandomize() are expressed in
+	enum { sfxrSupersampling = 8 };
+
+	// longest block the voices render at once
+	enum { maxBlockSize = 64 };
+
+	// sub-steps rendered per sample; each module instantiates a kernel for every supported factor
+	int supersampling{ sfxrSupersampling };
+	// the factor the voice state is currently scaled for
+	int renderedSupersampling{ sfxrSupersampling };
+
+	// frames rendered per block, reading params and CVs once per block; a block of n frames delays the outputs by n - 1 samples
+	int blockSize{ 1 };
+
+	// resolution of the main output, 8 bits as in sfxr
+	int bitDepth{ 8 };
+	// rendered frames the main output holds each value for, reducing its sample rate
+	int rateReduction{ 1 };
+
+	// reads the pitch input every sample instead of only on triggers, so it can be modulated at audio rate
+	bool trackPitch{ false };
+
+	// the rate the voices render at, resampled to the engine rate, so that their timbre doesn't depend on it;
+	// 0 renders at the engine rate. Resampling delays the outputs by resamplerTaps / 2 samples at the render rate.
+	int renderRate{ 0 };
+
+	enum { resamplerTaps = 16, resamplerPhases = 64 };
+
+	using Resampler = dsp::TPolyphaseResampler<simd::float_4, resamplerTaps>;
+
+	// how the frames rendered at renderRate line up with the engine frames of the block
+	struct Resampling
+	{
+		dsp::PolyphaseKernel<resamplerTaps, resamplerPhases> kernel;
+		// the rates the kernel was designed for
+		int renderRate{};
+		float sampleRate{};
+		// whether the block is resampled at all, and whether the voices start their resamplers over for it
+		bool active{};
+		bool restarted{};
+
+		// how far the next engine frame falls past the last rendered frame, in rendered frames
+		double position{};
+		// the frames rendered before each engine frame, and the kernel row interpolating it
+		int steps[maxBlockSize]{};
+		const float* rows[maxBlockSize]{};
+	};
+
+	Resampling resampling;
+
+	// play triggers of the block being captured, and the shape of the block being streamed out
+	struct Block
+	{
+		dsp::TSubSampleTrigger<simd::float_4> triggerPlay[PORT_MAX_CHANNELS / 4];
+		// bit c is set at the frames where channel c was triggered
+		std::uint16_t triggers[maxBlockSize]{};
+		// for the triggered channels, how long before the frame their trigger crossed, in engine samples
+		simd::float_4 elapsed[maxBlockSize][PORT_MAX_CHANNELS / 4]{};
+		// the pitch input at every frame, captured while tracking pitch
+		simd::float_4 pitch[maxBlockSize][PORT_MAX_CHANNELS / 4]{};
+
+		int size{ 1 };
+		int frame{};
+		bool trackPitch{ false };
+
+		int renderedSize{ 1 };
+		int renderedChannels{ 1 };
+
+		// channels of the group starting at c that were triggered at frame, as a lane mask
+		simd::float_4 getTriggers(int frame, int c) const
+		{
+			return math::laneMask(triggers[frame] >> c);
+		}
+
+		// the first frame from frame on where a channel of the group starting at c was triggered, or size
+		int findTrigger(int frame, int c) const
+		{
+			while (frame < size && !((triggers[frame] >> c) & 0xf))
+				++frame;
+
+			return frame;
+		}
+
+		void reset()
+		{
+			for (auto& trigger : triggerPlay)
+				trigger.reset();
+		}
+	};
+
+	Block block;
+
+	// replays one-shots from oneShotCache when a trigger repeats the parameters of an earlier one; needs the play
+	// trigger input and is bypassed while tracking pitch. The cache is only allocated while this is on.
+	std::atomic<bool> cacheOneShots{ false };
+	OneShotCache oneShotCache;
+	// raised by the audio thread before it reads cacheOneShots and lowered once it has let go of the cache, so that the
+	// UI thread can tell when turning caching off has taken effect and the cache can be freed
+	std::atomic<bool> oneShotCacheInUse{ false };
+
+	// how each channel plays its current one-shot: live, optionally recording it, or replaying it from the cache
+	struct Replay
+	{
+		OneShotCache::Entry* entry{};
+		int position{};
+		bool live{ true };
+	};
+
+	Replay replays[PORT_MAX_CHANNELS];
+
+	// per-module generator, so that voices on different engine threads never share random state;
+	// its seed is saved with the patch
+	math::Random random{ rack::random::u64() };
+
+	static bool isSupersamplingSupported(int value)
+	{
+		return value == 1 || value == 2 || value == 4 || value == 8 || value == 16;
+	}
+
+	static bool isBitDepthSupported(int value)
+	{
+		return value >= 1 && value <= 24;
+	}
+
+	static bool isRateReductionSupported(int value)
+	{
+		return value >= 1 && value <= 16;
+	}
+
+	static bool isRenderRateSupported(int value)
+	{
+		return value == 0 || value == 22050 || value == 44100 || value == 48000;
+	}
+
+	// feeds one sample of the play trigger input into the block; returns true once the block is complete and must be rendered
+	bool captureFrame(Input& triggerInput, Input& pitchInput, int channels)
+	{
+		const auto connected = triggerInput.isConnected();
+
+		unsigned triggered = 0;
+		for (int c = 0; c < channels; c += 4)
+		{
+			auto& trigger = block.triggerPlay[c / 4];
+			triggered |= simd::movemask(trigger.process(connected ? (triggerInput.getPolyVoltageSimd<simd::float_4>(c) - 0.1f) / (2.f - 0.1f) : 0.f)) << c;
+			block.elapsed[block.frame][c / 4] = trigger.elapsed;
+		}
+
+		block.triggers[block.frame] = triggered;
+
+		if (block.trackPitch)
+			for (int c = 0; c < channels; c += 4)
+				block.pitch[block.frame][c / 4] = pitchInput.getPolyVoltageSimd<simd::float_4>(c);
+
+		return ++block.frame == block.size;
+	}
+
+	// whether the frame being processed caches one-shots
+	bool startCaching(bool playTriggerInputConnected)
+	{
+		oneShotCacheInUse = true;
+		const auto caching = cacheOneShots && playTriggerInputConnected && !block.trackPitch;
+		if (!caching)
+		{
+			releaseReplays();
+			oneShotCacheInUse = false;
+		}
+
+		return caching;
+	}
+
+	// turns caching on or off from outside the audio thread, allocating the cache first when turning it on
+	void setCacheOneShots(bool cache)
+	{
+		if (cache && !oneShotCache.isAllocated())
+			oneShotCache.allocate();
+
+		cacheOneShots = cache;
+		freeUnusedOneShotCache();
+	}
+
+	// frees the cache once caching is off and the audio thread no longer uses it; polled from the UI thread
+	void freeUnusedOneShotCache()
+	{
+		if (!cacheOneShots && !oneShotCacheInUse && oneShotCache.isAllocated())
+			oneShotCache.free();
+	}
+
+	void releaseReplay(Replay& replay)
+	{
+		if (replay.entry)
+			--replay.entry->users;
+
+		replay.entry = nullptr;
+		replay.position = 0;
+	}
+
+	// returns every channel to live synthesis; a channel that was replaying has its live voice stopped, so it stays silent
+	void releaseReplays()
+	{
+		for (auto& replay : replays)
+		{
+			releaseReplay(replay);
+			replay.live = true;
+		}
+	}
+
+	// starts the one-shots of the triggered lanes of the group starting at c, recording the ones the cache lacks;
+	// returns the lanes that replay theirs instead of starting their live voice. makeKey(i) gives lane i's parameters.
+	template<typename MakeKey>
+	simd::float_4 startOneShots(int c, int lanes, simd::float_4 triggered, MakeKey makeKey)
+	{
+		const auto triggeredLanes = simd::movemask(triggered);
+
+		int replayed = 0;
+		for (int i = 0; i < lanes; ++i)
+		{
+			if (!(triggeredLanes & (1 << i)))
+				continue;
+
+			auto& replay = replays[c + i];
+			releaseReplay(replay);
+
+			const auto key = makeKey(i);
+			replay.entry = oneShotCache.find(key);
+			replay.live = !replay.entry;
+			if (replay.live)
+				replay.entry = oneShotCache.record(key);
+
+			if (replay.entry)
+				++replay.entry->users;
+
+			if (!replay.live)
+				replayed |= 1 << i;
+		}
+
+		return math::laneMask(replayed);
+	}
+
+	// records the live outputs of the group starting at c into the cache (at most OneShotCache::maxOutputs of them), or replaces them with the cached ones;
+	// done marks the lanes whose live one-shot had already ended before this frame
+	void cacheFrame(int c, int lanes, simd::float_4 done, simd::float_4* outputs, int outputCount)
+	{
+		const auto doneLanes = simd::movemask(done);
+		for (int i = 0; i < lanes; ++i)
+		{
+			auto& replay = replays[c + i];
+			if (!replay.entry)
+			{
+				if (!replay.live)
+					for (int o = 0; o < outputCount; ++o)
+						outputs[o][i] = 0.f;
+			}
+			else if (replay.live)
+			{
+				if (doneLanes & (1 << i))
+				{
+					replay.entry->complete = true;
+					releaseReplay(replay);
+				}
+				else if (replay.entry->frames.size() == static_cast<size_t>(OneShotCache::maxFrames * outputCount))
+				{
+					// too long to cache: the lane finishes live and the entry is the first to be recorded over
+					replay.entry->lastUsed = 0;
+					releaseReplay(replay);
+				}
+				else
+				{
+					for (int o = 0; o < outputCount; ++o)
+						replay.entry->frames.push_back(outputs[o][i]);
+				}
+			}
+			else
+			{
+				for (int o = 0; o < outputCount; ++o)
+					outputs[o][i] = replay.entry->frames[replay.position++];
+
+				if (replay.position == static_cast<int>(replay.entry->frames.size()))
+					releaseReplay(replay);
+			}
+		}
+	}
+
+	// the rate to render the captured block at; when that isn't the engine rate, lines up the rendered frames with
+	// the engine frames in resampling
+	float scheduleBlock(float sampleRate)
+	{
+		const auto rate = renderRate;
+		resampling.active = rate && rate != sampleRate;
+		if (!resampling.active)
+		{
+			resampling.renderRate = 0;
+			return sampleRate;
+		}
+
+		resampling.restarted = resampling.renderRate != rate || resampling.sampleRate != sampleRate;
+		if (resampling.restarted)
+		{
+			// leave a margin below the lower of the two Nyquist frequencies for the kernel's transition band
+			resampling.kernel.design(0.9f * std::min(1.f, sampleRate / rate));
+			resampling.renderRate = rate;
+			resampling.sampleRate = sampleRate;
+			resampling.position = 0.;
+		}
+
+		const auto ratio = static_cast<double>(rate) / sampleRate;
+		for (int frame = 0; frame < block.size; ++frame)
+		{
+			resampling.position += ratio;
+			resampling.steps[frame] = static_cast<int>(resampling.position);
+			resampling.position -= resampling.steps[frame];
+			resampling.rows[frame] = resampling.kernel.coefficients[static_cast<int>(resampling.position * resamplerPhases + 0.5)];
+		}
+
+		return static_cast<float>(rate);
+	}
+
+	// drops the captured triggers and the cached one-shots
+	void resetRendering()
+	{
+		block.reset();
+		releaseReplays();
+		oneShotCache.clear();
+	}
+
+	// called once the captured block has been rendered, to start capturing the next one at the current block size
+	void startBlock(int channels)
+	{
+		block.renderedSize = block.size;
+		block.renderedChannels = channels;
+		block.size = blockSize;
+		block.frame = 0;
+		block.trackPitch = trackPitch;
+	}
+
+	// the frame of the rendered block to output now; after a block size change the first block is cut short or holds its last frame
+	int getOutputFrame() const
+	{
+		return std::min(block.frame, block.renderedSize - 1);
+	}
+
+	json_t* dataToJson() override
+	{
+		if (json_t* rootJ = json_object())
+		{
+			json_object_set_new(rootJ, "supersampling", json_integer(supersampling));
+			json_object_set_new(rootJ, "blockSize", json_integer(blockSize));
+			json_object_set_new(rootJ, "bitDepth", json_integer(bitDepth));
+			json_object_set_new(rootJ, "rateReduction", json_integer(rateReduction));
+			json_object_set_new(rootJ, "trackPitch", json_boolean(trackPitch));
+			json_object_set_new(rootJ, "renderRate", json_integer(renderRate));
+			json_object_set_new(rootJ, "cacheOneShots", json_boolean(cacheOneShots.load()));
+			json_object_set_new(rootJ, "seed", json_integer(static_cast<json_int_t>(random.seed)));
+			return rootJ;
+		}
+
+		return nullptr;
+	}
+
+	void dataFromJson(json_t* rootJ) override
+	{
+		supersampling = sfxrSupersampling;
+		blockSize = 1;
+		bitDepth = 8;
+		rateReduction = 1;
+		trackPitch = false;
+		renderRate = 0;
+		auto cache = false;
+
+		if (rootJ)
+			if (auto supersamplingJson = json_object_get(rootJ, "supersampling"))
+				if (isSupersamplingSupported(json_integer_value(supersamplingJson)))
+					supersampling = json_integer_value(supersamplingJson);
+
+		if (rootJ)
+			if (auto blockSizeJson = json_object_get(rootJ, "blockSize"))
+				if (json_integer_value(blockSizeJson) >= 1 && json_integer_value(blockSizeJson) <= maxBlockSize)
+					blockSize = json_integer_value(blockSizeJson);
+
+		if (rootJ)
+			if (auto bitDepthJson = json_object_get(rootJ, "bitDepth"))
+				if (isBitDepthSupported(json_integer_value(bitDepthJson)))
+					bitDepth = json_integer_value(bitDepthJson);
+
+		if (rootJ)
+			if (auto rateReductionJson = json_object_get(rootJ, "rateReduction"))
+				if (isRateReductionSupported(json_integer_value(rateReductionJson)))
+					rateReduction = json_integer_value(rateReductionJson);
+
+		if (rootJ)
+			if (auto trackPitchJson = json_object_get(rootJ, "trackPitch"))
+				trackPitch = json_boolean_value(trackPitchJson);
+
+		if (rootJ)
+			if (auto renderRateJson = json_object_get(rootJ, "renderRate"))
+				if (isRenderRateSupported(json_integer_value(renderRateJson)))
+					renderRate = json_integer_value(renderRateJson);
+
+		if (rootJ)
+			if (auto cacheOneShotsJson = json_object_get(rootJ, "cacheOneShots"))
+				cache = json_boolean_value(cacheOneShotsJson);
+
+		setCacheOneShots(cache);
+
+		if (rootJ)
+			if (auto seedJson = json_object_get(rootJ, "seed"))
+				random.setSeed(static_cast<std::uint64_t>(json_integer_value(seedJson)));
+	}
+
+	struct BaseWidget : gui::BaseModuleWidget
+	{
+		using BasicMenuItem = gui::BasicMenuItem<SfxrBase>;
+
+		struct SupersamplingSubmenuItem : BasicMenuItem
+		{
+			Menu* createChildMenu() override
+			{
+				struct SupersamplingItem : BasicMenuItem
+				{
+					SupersamplingItem(int supersampling) : supersampling(supersampling) {}
+
+					int supersampling{};
+					void onAction(const event::Action& e) override
+					{
+						module->supersampling = supersampling;
+					}
+				};
+
+				Menu* menu = new Menu;
+				for (auto supersampling = 1; supersampling <= 16; supersampling *= 2)
+					menu->addChild(createMenuItem<SupersamplingItem>(module, std::to_string(supersampling) + "x", CHECKMARK(module->supersampling == supersampling), supersampling));
+				return menu;
+			}
+
+			static MenuItem* create(SfxrBase* module)
+			{
+				return createMenuItem<SupersamplingSubmenuItem>(module, "Supersampling:", std::to_string(module->supersampling) + "x  " + RIGHT_ARROW);
+			}
+		};
+
+		struct BlockSizeSubmenuItem : BasicMenuItem
+		{
+			Menu* createChildMenu() override
+			{
+				struct BlockSizeItem : BasicMenuItem
+				{
+					BlockSizeItem(int blockSize) : blockSize(blockSize) {}
+
+					int blockSize{};
+					void onAction(const event::Action& e) override
+					{
+						module->blockSize = blockSize;
+					}
+				};
+
+				Menu* menu = new Menu;
+				for (auto blockSize = 1; blockSize <= maxBlockSize; blockSize *= 2)
+					menu->addChild(createMenuItem<BlockSizeItem>(module, std::to_string(blockSize), CHECKMARK(module->blockSize == blockSize), blockSize));
+				return menu;
+			}
+
+			static MenuItem* create(SfxrBase* module)
+			{
+				return createMenuItem<BlockSizeSubmenuItem>(module, "Block size:", std::to_string(module->blockSize) + "  " + RIGHT_ARROW);
+			}
+		};
+
+		struct BitDepthSubmenuItem : BasicMenuItem
+		{
+			Menu* createChildMenu() override
+			{
+				struct BitDepthItem : BasicMenuItem
+				{
+					BitDepthItem(int bitDepth) : bitDepth(bitDepth) {}
+
+					int bitDepth{};
+					void onAction(const event::Action& e) override
+					{
+						module->bitDepth = bitDepth;
+					}
+				};
+
+				Menu* menu = new Menu;
+				for (auto bitDepth : { 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 16, 24 })
+					menu->addChild(createMenuItem<BitDepthItem>(module, std::to_string(bitDepth) + " bit", CHECKMARK(module->bitDepth == bitDepth), bitDepth));
+				return menu;
+			}
+
+			static MenuItem* create(SfxrBase* module)
+			{
+				return createMenuItem<BitDepthSubmenuItem>(module, "Bit depth:", std::to_string(module->bitDepth) + " bit  " + RIGHT_ARROW);
+			}
+		};
+
+		struct RateReductionSubmenuItem : BasicMenuItem
+		{
+			static std::string getLabel(int rateReduction)
+			{
+				return rateReduction == 1 ? "Off" : "1/" + std::to_string(rateReduction);
+			}
+
+			Menu* createChildMenu() override
+			{
+				struct RateReductionItem : BasicMenuItem
+				{
+					RateReductionItem(int rateReduction) : rateReduction(rateReduction) {}
+
+					int rateReduction{};
+					void onAction(const event::Action& e) override
+					{
+						module->rateReduction = rateReduction;
+					}
+				};
+
+				Menu* menu = new Menu;
+				for (auto rateReduction : { 1, 2, 3, 4, 6, 8, 12, 16 })
+					menu->addChild(createMenuItem<RateReductionItem>(module, getLabel(rateReduction), CHECKMARK(module->rateReduction == rateReduction), rateReduction));
+				return menu;
+			}
+
+			static MenuItem* create(SfxrBase* module)
+			{
+				return createMenuItem<RateReductionSubmenuItem>(module, "Rate reduction:", getLabel(module->rateReduction) + "  " + RIGHT_ARROW);
+			}
+		};
+
+		struct TrackPitchItem : BasicMenuItem
+		{
+			void onAction(const event::Action& e) override
+			{
+				module->trackPitch = !module->trackPitch;
+			}
+
+			static MenuItem* create(SfxrBase* module)
+			{
+				return createMenuItem<TrackPitchItem>(module, "Track pitch continuously", CHECKMARK(module->trackPitch));
+			}
+		};
+
+		struct RenderRateSubmenuItem : BasicMenuItem
+		{
+			static std::string getLabel(int renderRate)
+			{
+				return renderRate ? std::to_string(renderRate) + " Hz" : "Engine rate";
+			}
+
+			Menu* createChildMenu() override
+			{
+				struct RenderRateItem : BasicMenuItem
+				{
+					RenderRateItem(int renderRate) : renderRate(renderRate) {}
+
+					int renderRate{};
+					void onAction(const event::Action& e) override
+					{
+						module->renderRate = renderRate;
+					}
+				};
+
+				Menu* menu = new Menu;
+				for (auto renderRate : { 0, 22050, 44100, 48000 })
+					menu->addChild(createMenuItem<RenderRateItem>(module, getLabel(renderRate), CHECKMARK(module->renderRate == renderRate), renderRate));
+				return menu;
+			}
+
+			static MenuItem* create(SfxrBase* module)
+			{
+				return createMenuItem<RenderRateSubmenuItem>(module, "Render rate:", getLabel(module->renderRate) + "  " + RIGHT_ARROW);
+			}
+		};
+
+		struct CacheOneShotsItem : BasicMenuItem
+		{
+			void onAction(const event::Action& e) override
+			{
+				module->setCacheOneShots(!module->cacheOneShots);
+			}
+
+			static MenuItem* create(SfxrBase* module)
+			{
+				return createMenuItem<CacheOneShotsItem>(module, "Cache one-shots", CHECKMARK(module->cacheOneShots.load()));
+			}
+		};
+
+		void appendContextMenu(Menu* menu) override
+		{
+			menu->addChild(new MenuSeparator);
+			menu->addChild(SupersamplingSubmenuItem::create(dynamic_cast<SfxrBase*>(module)));
+			menu->addChild(BlockSizeSubmenuItem::create(dynamic_cast<SfxrBase*>(module)));
+			menu->addChild(BitDepthSubmenuItem::create(dynamic_cast<SfxrBase*>(module)));
+			menu->addChild(RateReductionSubmenuItem::create(dynamic_cast<SfxrBase*>(module)));
+			menu->addChild(TrackPitchItem::create(dynamic_cast<SfxrBase*>(module)));
+			menu->addChild(RenderRateSubmenuItem::create(dynamic_cast<SfxrBase*>(module)));
+			menu->addChild(CacheOneShotsItem::create(dynamic_cast<SfxrBase*>(module)));
+		}
+
+		void step() override
+		{
+			if (auto sfxrModule = dynamic_cast<SfxrBase*>(module))
+				sfxrModule->freeUnusedOneShotCache();
+
+			gui::BaseModuleWidget::step();
+		}
+	};
+};
+
+} // namespace DigitalAtavism
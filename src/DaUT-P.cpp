@@ -94,6 +94,21 @@ struct UT_Base : Module
 {
 	VoltageRange::Value voltageRange{ VoltageRange::RangeA };
 
+	// the selector's mapping of voltageRange onto [0, 1], recomputed only when the range changes
+	VoltageRange::Value scaledVoltageRange{ VoltageRange::COUNT };
+	float rangeMinimum{};
+	float rangeScale{};
+
+	void updateRangeScale()
+	{
+		if (scaledVoltageRange == voltageRange)
+			return;
+
+		scaledVoltageRange = voltageRange;
+		rangeMinimum = VoltageRange::GetMinimum(voltageRange);
+		rangeScale = 1.0f / (VoltageRange::GetMaximum(voltageRange) - rangeMinimum);
+	}
+
 	json_t* dataToJson() override
 	{
 		if (json_t* rootJ = json_object())
@@ -156,39 +171,164 @@ struct UT_Base : Module
 		}
 	};
 
-	struct ExpanderMessages
+	// UT-P's signal input and the three of a UT-B to its left, chained one after another, make a bank of up to this many channels
+	enum { maxBankChannels = 4 * PORT_MAX_CHANNELS };
+
+	// a frame of UT-P's signal inputs, with room for a four-wide load starting at any channel
+	struct BusFrame
 	{
 		int numberOfInputs{ PORT_MAX_CHANNELS };
-		float inputs[PORT_MAX_CHANNELS]{};
+		float inputs[maxBankChannels + 3]{};
 	};
 
-	static int calculateChannelIndex(int channels, float voltage, float minimumVoltage = 0.0f, float maximumVoltage = 10.0f)
+	// UT-P publishes each frame of its signal input here once, and every UT-OX of the chain to its right reads it in
+	// place. Modules are processed in no particular order and on several threads, so UT-P writes the current frame while
+	// the chain reads the previous one, which nothing writes: every UT-OX is one sample behind UT-P, however long the chain.
+	struct Bus
+	{
+		BusFrame frames[2];
+
+		BusFrame& publish(std::int64_t frame) { return frames[frame & 1]; }
+		const BusFrame& read(std::int64_t frame) const { return frames[(frame + 1) & 1]; }
+	};
+
+	// the input channel a voltage selects, after updateRangeScale()
+	int calculateChannelIndex(int channels, float voltage) const
 	{
 		if (channels <= 1)
 			return 0;
 
 		const auto n_1 = channels - 1;
-		return clamp(static_cast<int>(n_1 * ((voltage - minimumVoltage) / (maximumVoltage - minimumVoltage)) + 0.5f), 0, n_1);
+		return clamp(static_cast<int>(n_1 * ((voltage - rangeMinimum) * rangeScale) + 0.5f), 0, n_1);
+	}
+
+	// the same for four voltages at once; clamping before the conversion truncates just like the scalar version
+	simd::int32_4 calculateChannelIndex(int channels, simd::float_4 voltages) const
+	{
+		const auto n_1 = static_cast<float>(std::max(channels - 1, 0));
+		return simd::int32_4(simd::clamp(n_1 * ((voltages - rangeMinimum) * rangeScale) + 0.5f, 0.0f, n_1));
 	}
 
 	static bool checkModel(const Module* module, const Model* model)
 	{
 		return module && module->model == model;
 	}
+};
+
+
 
-	template<typename Models>
-	static bool checkModels(const Module* module, Models models)
+// the signal bank expander: placed directly to the left of a UT-P, extends its signal input with three more
+struct UT_B : Module
+{
+	enum ParamIds
+	{
+		NUM_PARAMS
+	};
+	enum InputIds
 	{
-		if (module)
-			for (const auto& model : models)
-				if (module->model == model)
-					return true;
+		SIGNAL_2_INPUT,
+		SIGNAL_3_INPUT,
+		SIGNAL_4_INPUT,
+		NUM_INPUTS
+	};
+	enum OutputIds
+	{
+		NUM_OUTPUTS
+	};
+	enum LightIds
+	{
+		NUM_LIGHTS
+	};
+
+	UT_B()
+	{
+		INFO("DigitalAtavism - UT-B: %i params  %i inputs  %i outputs  %i lights", NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+
+		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+
+		configInput(SIGNAL_2_INPUT, "Signal bank 2");
+		configInput(SIGNAL_3_INPUT, "Signal bank 3");
+		configInput(SIGNAL_4_INPUT, "Signal bank 4");
+	}
+
+	bool isPatched()
+	{
+		for (auto& input : inputs)
+			if (input.isConnected())
+				return true;
 
 		return false;
 	}
-};
 
+	struct Widget : gui::BaseModuleWidget
+	{
+		using MyModule = UT_B;
+
+		Widget(MyModule* module)
+		{
+			setModule(module);
+
+			box.size = Vec(RACK_GRID_WIDTH * 3, RACK_GRID_HEIGHT);
+
+			addName("ut-b", "DA");
 
+			addChild(createWidget<ScrewBlack>(Vec(RACK_GRID_WIDTH, 0)));
+			addChild(createWidget<ScrewBlack>(Vec(RACK_GRID_WIDTH, RACK_GRID_HEIGHT - RACK_GRID_WIDTH)));
+			addChild(createWidget<ScrewSilver>(Vec(RACK_GRID_WIDTH / 4, RACK_GRID_WIDTH * 3)));
+			addChild(createWidget<ScrewSilver>(Vec(RACK_GRID_WIDTH / 4, RACK_GRID_HEIGHT - RACK_GRID_WIDTH * 4)));
+
+			// lined up with UT-P's IN, which comes first in the bank
+			auto yPos = RACK_GRID_WIDTH * 6;
+			const char* signalLabels[] = { "IN 2", "IN 3", "IN 4" };
+			for (int i = 0; i < NUM_INPUTS; ++i)
+			{
+				addChild(new gui::TextLabel<NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE>(box.size.x / 2, yPos - RACK_GRID_WIDTH * 5 / 4, signalLabels[i], smallFontSize, smallFontDark, smallFont));
+				addInput(createInputCentered<PJ301MPort>(Vec(box.size.x / 2, yPos), module, SIGNAL_2_INPUT + i));
+				yPos += RACK_GRID_WIDTH * 3.25f;
+			}
+		}
+
+		void draw(const DrawArgs& args) override
+		{
+			{
+				nvgStrokeColor(args.vg, nvgRGB(0, 0, 0));
+				nvgFillColor(args.vg, nvgRGB(0xc9, 0xc9, 0xc9));
+				nvgStrokeWidth(args.vg, 1);
+				nvgBeginPath(args.vg);
+				nvgRect(args.vg, RACK_GRID_WIDTH / 4, RACK_GRID_WIDTH * 3, box.size.x - RACK_GRID_WIDTH / 2, box.size.y - RACK_GRID_WIDTH * 6);
+				nvgStroke(args.vg);
+				nvgFill(args.vg);
+			}
+
+			{
+				nvgStrokeColor(args.vg, getBackgroundStrokeColor());
+				nvgFillColor(args.vg, getBackgroundFillColor());
+				nvgStrokeWidth(args.vg, 1);
+				nvgBeginPath(args.vg);
+				nvgRoundedRect(args.vg, 1, 1, box.size.x - 2, box.size.y - 2, 5);
+				nvgStroke(args.vg);
+				nvgFill(args.vg);
+			}
+
+			{
+				nvgStrokeColor(args.vg, nvgRGB(54, 54, 54));
+				nvgFillColor(args.vg, nvgRGB(189, 189, 189));
+				nvgStrokeWidth(args.vg, 1);
+				nvgBeginPath(args.vg);
+				nvgRoundedRect(args.vg, RACK_GRID_WIDTH * 0.5f, RACK_GRID_WIDTH * 4.25f, RACK_GRID_WIDTH * 2, RACK_GRID_WIDTH * 3, 5);
+				nvgRoundedRect(args.vg, RACK_GRID_WIDTH * 0.5f, RACK_GRID_WIDTH * 7.50f, RACK_GRID_WIDTH * 2, RACK_GRID_WIDTH * 3, 5);
+				nvgRoundedRect(args.vg, RACK_GRID_WIDTH * 0.5f, RACK_GRID_WIDTH * 10.75f, RACK_GRID_WIDTH * 2, RACK_GRID_WIDTH * 3, 5);
+				nvgStroke(args.vg);
+				nvgFill(args.vg);
+			}
+
+			ModuleWidget::draw(args);
+		}
+
+		NVGcolor getBackgroundFillColor() override { return nvgRGBA(0xb4, 0xb4, 0xc6, 0x1a); }
+		NVGcolor getBackgroundStrokeColor() override { return nvgRGBA(0x7b, 0xc6, 0xc6, 0x7f); }
+	};
+};
 
 struct UT_P : UT_Base
 {
@@ -232,29 +372,141 @@ struct UT_P : UT_Base
 		onReset();
 	}
 
-	rack::dsp::BooleanTrigger triggers[PORT_MAX_CHANNELS];
-	rack::dsp::PulseGenerator pulseGenerators[PORT_MAX_CHANNELS];
+	// bit i is set while output channel i selects input channel i, or while channel i is unused; a trigger starts
+	// when a bit is set
+	int selfSelectedChannels{ ~0 };
+	dsp::TTickPulseGenerator<simd::float_4> pulseGenerators[PORT_MAX_CHANNELS / 4];
+
+	Bus bus;
+	// whether a UT-OX reads the bus, and the UT-B extending the signal input, if there is one; only checked when the
+	// expanders change
+	bool chained{};
+	UT_B* bank{};
+	// the signal inputs while no UT-OX reads them
+	BusFrame signalFrame;
+
+	// above 1, the CV selects a window of this many adjacent input channels instead of a single one
+	int windowSize{ 1 };
+	// the first input channel of the window, and whether it moved in the last sample or the window is off; a trigger
+	// starts when the window starts moving
+	int windowStart{};
+	bool windowShifting{ true };
+
+	static bool isWindowSizeSupported(int value)
+	{
+		return value >= 1 && value <= PORT_MAX_CHANNELS;
+	}
 
 	void onReset() override
 	{
-		for (auto& trigger : triggers)
-			trigger.reset();
+		selfSelectedChannels = ~0;
+		windowShifting = true;
 
 		for (auto& pulseGenerator : pulseGenerators)
 			pulseGenerator.reset();
 	}
 
+	json_t* dataToJson() override
+	{
+		json_t* rootJ = UT_Base::dataToJson();
+		if (rootJ)
+			json_object_set_new(rootJ, "windowSize", json_integer(windowSize));
+
+		return rootJ;
+	}
+
+	void dataFromJson(json_t* rootJ) override
+	{
+		UT_Base::dataFromJson(rootJ);
+
+		windowSize = 1;
+
+		if (rootJ)
+			if (auto windowSizeJson = json_object_get(rootJ, "windowSize"))
+				if (isWindowSizeSupported(json_integer_value(windowSizeJson)))
+					windowSize = json_integer_value(windowSizeJson);
+	}
+
+	// the CV's first channel selects windowSize adjacent input channels, which are copied to as many output channels;
+	// the window stops at the last input channel, and all its channels trigger when it moves
+	void processWindow(const ProcessArgs &args, const BusFrame& frame, int numberOfInputChannels)
+	{
+		const auto channels = windowSize;
+
+		outputs[GATE_OUTPUT].setChannels(channels);
+		outputs[SIGNAL_OUTPUT].setChannels(channels);
+		outputs[TRIGGER_OUTPUT].setChannels(channels);
+
+		const auto start = calculateChannelIndex(std::max(numberOfInputChannels - channels + 1, 1), inputs[CV_INPUT].getVoltage());
+		const auto filled = simd::int32_4(std::min(numberOfInputChannels - start, channels));
+
+		const auto shifting = numberOfInputChannels && start != windowStart;
+		const auto triggered = shifting && !windowShifting;
+		windowShifting = shifting;
+		windowStart = start;
+
+		const auto pulseSamples = simd::int32_4(math::toSamples(1e-3f, args.sampleRate));
+		for (int c = 0; c < PORT_MAX_CHANNELS; c += 4)
+		{
+			auto& pulseGenerator = pulseGenerators[c / 4];
+			if (c >= channels)
+			{
+				pulseGenerator.reset();
+				continue;
+			}
+
+			// input channels past the last one are stale
+			const auto used = simd::float_4::cast(simd::int32_4(c, c + 1, c + 2, c + 3) < filled);
+			outputs[GATE_OUTPUT].setVoltageSimd(used & simd::float_4(10.0f), c);
+			outputs[SIGNAL_OUTPUT].setVoltageSimd(used & simd::float_4::load(frame.inputs + start + c), c);
+
+			if (triggered)
+				pulseGenerator.trigger(simd::float_4::mask(), pulseSamples);
+
+			outputs[TRIGGER_OUTPUT].setVoltageSimd(pulseGenerator.process() & simd::float_4(10.0f), c);
+		}
+
+		selfSelectedChannels = ~0;
+	}
+
+	static void appendToBank(BusFrame& frame, Input& input)
+	{
+		const auto voltages = input.getVoltages();
+		std::copy(voltages, voltages + input.getChannels(), frame.inputs + frame.numberOfInputs);
+		frame.numberOfInputs += input.getChannels();
+	}
+
 	void process(const ProcessArgs &args) override
 	{
-		const auto minimumVoltage{ VoltageRange::GetMinimum(voltageRange) };
-		const auto maximumVoltage{ VoltageRange::GetMaximum(voltageRange) };
+		updateRangeScale();
+
+		// the signal inputs are selected from as one bank, in a single contiguous frame that is also the chain's bus
+		auto& frame = chained ? bus.publish(args.frame) : signalFrame;
+		frame.numberOfInputs = 0;
+		appendToBank(frame, inputs[SIGNAL_INPUT]);
+		if (bank)
+			for (auto& input : bank->inputs)
+				appendToBank(frame, input);
+
+		const auto numberOfInputChannels = frame.numberOfInputs;
+
+		if (windowSize > 1)
+		{
+			processWindow(args, frame, numberOfInputChannels);
+			return;
+		}
+
+		windowShifting = true;
 
-		const auto numberOfInputChannels = inputs[SIGNAL_INPUT].getChannels();
-		const auto polyCV = inputs[CV_INPUT].isPolyphonic();
-		const auto numberOfOutputChannels = polyCV ? inputs[CV_INPUT].getChannels() : numberOfInputChannels ? numberOfInputChannels : 1;
+		// a bank can hold more channels than an output, so with one each CV channel selects for its own output channel,
+		// even a mono CV
+		const auto banked = bank && bank->isPatched();
+		const auto polyCV = inputs[CV_INPUT].isPolyphonic() || banked;
+		const auto numberOfOutputChannels = polyCV ? std::max(1, inputs[CV_INPUT].getChannels()) : numberOfInputChannels ? numberOfInputChannels : 1;
 
 		outputs[GATE_OUTPUT].setChannels(numberOfOutputChannels);
 		outputs[SIGNAL_OUTPUT].setChannels(numberOfOutputChannels);
+		outputs[TRIGGER_OUTPUT].setChannels(numberOfOutputChannels);
 
 		if (!polyCV || !numberOfInputChannels)
 		{
@@ -262,57 +514,52 @@ struct UT_P : UT_Base
 			outputs[SIGNAL_OUTPUT].clearVoltages();
 		}
 
-		outputs[TRIGGER_OUTPUT].setChannels(numberOfOutputChannels);
-		outputs[TRIGGER_OUTPUT].clearVoltages();
-
+		int selfSelected = 0;
 		if (numberOfInputChannels)
 		{
+			const auto signal = frame.inputs;
+
 			if (polyCV)
 			{
-				for (int i = 0; i < numberOfOutputChannels; ++i)
+				for (int c = 0; c < numberOfOutputChannels; c += 4)
 				{
-					const auto channel = calculateChannelIndex(numberOfInputChannels, inputs[CV_INPUT].getVoltage(i), minimumVoltage, maximumVoltage);
-					outputs[GATE_OUTPUT].setVoltage(10.0f, i);
-					outputs[SIGNAL_OUTPUT].setVoltage(inputs[SIGNAL_INPUT].getVoltage(channel), i);
-
-					if (triggers[i].process(channel == i))
-						pulseGenerators[i].trigger(1e-3f);
+					const auto channel = calculateChannelIndex(numberOfInputChannels, inputs[CV_INPUT].getVoltageSimd<simd::float_4>(c));
+					outputs[GATE_OUTPUT].setVoltageSimd(simd::float_4(10.0f), c);
+					outputs[SIGNAL_OUTPUT].setVoltageSimd(simd::float_4(signal[channel[0]], signal[channel[1]], signal[channel[2]], signal[channel[3]]), c);
+					selfSelected |= simd::movemask(simd::float_4::cast(channel == simd::int32_4(c, c + 1, c + 2, c + 3))) << c;
 				}
 			}
 			else
 			{
-				const auto channel = calculateChannelIndex(numberOfInputChannels, inputs[CV_INPUT].getVoltage(), minimumVoltage, maximumVoltage);
+				const auto channel = calculateChannelIndex(numberOfInputChannels, inputs[CV_INPUT].getVoltage());
 				outputs[GATE_OUTPUT].setVoltage(10.0f, channel);
-				outputs[SIGNAL_OUTPUT].setVoltage(inputs[SIGNAL_INPUT].getVoltage(channel), channel);
-
-				for (int i = 0; i < numberOfOutputChannels; ++i)
-					if (triggers[i].process(channel == i))
-						pulseGenerators[i].trigger(1e-3f);
+				outputs[SIGNAL_OUTPUT].setVoltage(signal[channel], channel);
+				selfSelected = 1 << channel;
 			}
 		}
 
-		for (int i = numberOfInputChannels ? numberOfOutputChannels : 0; i < PORT_MAX_CHANNELS; ++i)
-		{
-			triggers[i].reset();
-			pulseGenerators[i].reset();
-		}
-
-		for (int i = 0; i < numberOfOutputChannels; ++i)
-			outputs[TRIGGER_OUTPUT].setVoltage(pulseGenerators[i].process(args.sampleTime) ? 10.f : 0.f, i);
+		const auto usedChannels = numberOfInputChannels ? (1 << numberOfOutputChannels) - 1 : 0;
+		const auto triggered = selfSelected & ~selfSelectedChannels & usedChannels;
+		selfSelectedChannels = (selfSelected & usedChannels) | ~usedChannels;
 
-		if (checkModel(rightExpander.module, modelUtox))
+		const auto pulseSamples = simd::int32_4(math::toSamples(1e-3f, args.sampleRate));
+		for (int c = 0; c < PORT_MAX_CHANNELS; c += 4)
 		{
-			auto& rightLeftExpander = rightExpander.module->leftExpander;
-			auto& producerMessage = *reinterpret_cast<ExpanderMessages*>(rightLeftExpander.producerMessage);
-
-			const auto channels = producerMessage.numberOfInputs = inputs[SIGNAL_INPUT].getChannels();
-			for (int i = 0; i < channels; ++i)
-				producerMessage.inputs[i] = inputs[SIGNAL_INPUT].getVoltage(i);
+			auto& pulseGenerator = pulseGenerators[c / 4];
+			pulseGenerator.reset(math::laneMask(~usedChannels >> c));
+			pulseGenerator.trigger(math::laneMask(triggered >> c), pulseSamples);
 
-			rightLeftExpander.messageFlipRequested = true;
+			if (c < numberOfOutputChannels)
+				outputs[TRIGGER_OUTPUT].setVoltageSimd(pulseGenerator.process() & simd::float_4(10.0f), c);
 		}
 	}
 
+	void onExpanderChange(const ExpanderChangeEvent& e) override
+	{
+		chained = checkModel(rightExpander.module, modelUtox);
+		bank = checkModel(leftExpander.module, modelUtb) ? static_cast<UT_B*>(leftExpander.module) : nullptr;
+	}
+
 	struct Widget : BaseWidget
 	{
 		using MyModule = UT_P;
@@ -405,6 +652,46 @@ struct UT_P : UT_Base
 			ModuleWidget::draw(args);
 		}
 
+		using BasicMenuItem = gui::BasicMenuItem<MyModule>;
+
+		struct WindowSizeSubmenuItem : BasicMenuItem
+		{
+			static std::string getName(int windowSize)
+			{
+				return windowSize > 1 ? std::to_string(windowSize) + " channels" : "Off";
+			}
+
+			Menu* createChildMenu() override
+			{
+				struct WindowSizeItem : BasicMenuItem
+				{
+					WindowSizeItem(int windowSize) : windowSize(windowSize) {}
+
+					int windowSize{};
+					void onAction(const event::Action& e) override
+					{
+						module->windowSize = windowSize;
+					}
+				};
+
+				Menu* menu = new Menu;
+				for (auto windowSize : { 1, 2, 3, 4, 5, 6, 7, 8, 12, 16 })
+					menu->addChild(createMenuItem<WindowSizeItem>(module, getName(windowSize), CHECKMARK(module->windowSize == windowSize), windowSize));
+				return menu;
+			}
+
+			static MenuItem* create(MyModule* module)
+			{
+				return createMenuItem<WindowSizeSubmenuItem>(module, "Window:", getName(module->windowSize) + "  " + RIGHT_ARROW);
+			}
+		};
+
+		void appendContextMenu(Menu* menu) override
+		{
+			BaseWidget::appendContextMenu(menu);
+			menu->addChild(WindowSizeSubmenuItem::create(dynamic_cast<MyModule*>(module)));
+		}
+
 		void step() override
 		{
 			if (!module)
@@ -431,8 +718,6 @@ struct UT_P : UT_Base
 
 struct UT_OX : UT_Base
 {
-	ExpanderMessages leftMessages[2];
-
 	enum ParamIds
 	{
 		NUM_PARAMS
@@ -457,9 +742,6 @@ struct UT_OX : UT_Base
 	{
 		INFO("DigitalAtavism - UT-OX: %i params  %i inputs  %i outputs  %i lights", NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
 
-		leftExpander.producerMessage = &leftMessages[0];
-		leftExpander.consumerMessage = &leftMessages[1];
-
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
 
 		configInput(CV_INPUT, "Selector");
@@ -470,38 +752,80 @@ struct UT_OX : UT_Base
 		onReset();
 	}
 
-	rack::dsp::BooleanTrigger trigger;
-	rack::dsp::PulseGenerator pulseGenerator;
+	// the input channel each output channel selects, and bit i set while output channel i's selection is changing, or
+	// while channel i is unused; a trigger starts when a bit is set
+	simd::int32_4 selectedChannels[PORT_MAX_CHANNELS / 4]{};
+	int changingChannels{ ~0 };
+	dsp::TTickPulseGenerator<simd::float_4> pulseGenerators[PORT_MAX_CHANNELS / 4];
 
-	int selectedMonoChannel{};
+	// the bus of the UT-P at the head of this module's chain, if there is one
+	const Bus* bus{};
 
 	void onReset() override
 	{
-		trigger.reset();
-		pulseGenerator.reset();
+		changingChannels = ~0;
+
+		for (auto& pulseGenerator : pulseGenerators)
+			pulseGenerator.reset();
+	}
+
+	// hands the bus of the UT-P at the head of the chain to this and every UT-OX to its right, as only the modules next
+	// to a change are told about it
+	void bindChain()
+	{
+		auto head = leftExpander.module;
+		while (checkModel(head, modelUtox))
+			head = head->leftExpander.module;
+
+		const auto headBus = checkModel(head, modelUtp) ? &static_cast<UT_P*>(head)->bus : nullptr;
+		for (Module* module = this; checkModel(module, modelUtox); module = module->rightExpander.module)
+			static_cast<UT_OX*>(module)->bus = headBus;
+	}
+
+	void onExpanderChange(const ExpanderChangeEvent& e) override
+	{
+		bindChain();
 	}
 
 	void process(const ProcessArgs &args) override
 	{
-		const auto models = { modelUtp, modelUtox };
-		const auto isLeftExpanderValid = checkModels(leftExpander.module, models);
-		const ExpanderMessages emptyMessages;
-		const auto& consumerMessage = isLeftExpanderValid ? *reinterpret_cast<const ExpanderMessages*>(leftExpander.consumerMessage) : emptyMessages;
-		const auto previousSelectedMonoChannel = selectedMonoChannel;
-		selectedMonoChannel = calculateChannelIndex(consumerMessage.numberOfInputs, inputs[CV_INPUT].getVoltage(), VoltageRange::GetMinimum(voltageRange), VoltageRange::GetMaximum(voltageRange));
-		outputs[SIGNAL_OUTPUT].setVoltage(consumerMessage.inputs[selectedMonoChannel]);
+		static const BusFrame emptyFrame;
+		const auto& frame = bus ? bus->read(args.frame) : emptyFrame;
+
+		updateRangeScale();
 
-		if (trigger.process(selectedMonoChannel != previousSelectedMonoChannel))
-			pulseGenerator.trigger(1e-3f);
+		// one selected signal and change trigger per CV channel
+		const auto channels = std::max(1, inputs[CV_INPUT].getChannels());
+		const auto usedChannels = (1 << channels) - 1;
 
-		outputs[TRIGGER_OUTPUT].setVoltage(pulseGenerator.process(args.sampleTime) ? 10.f : 0.f);
+		outputs[SIGNAL_OUTPUT].setChannels(channels);
+		outputs[TRIGGER_OUTPUT].setChannels(channels);
 
-		if (checkModel(rightExpander.module, modelUtox))
+		int changing = 0;
+		for (int c = 0; c < channels; c += 4)
 		{
-			auto& expander = rightExpander.module->leftExpander;
-			auto& producerMessage = *reinterpret_cast<ExpanderMessages*>(expander.producerMessage);
-			producerMessage = consumerMessage;
-			expander.messageFlipRequested = true;
+			const auto channel = calculateChannelIndex(frame.numberOfInputs, inputs[CV_INPUT].getVoltageSimd<simd::float_4>(c));
+			outputs[SIGNAL_OUTPUT].setVoltageSimd(simd::float_4(frame.inputs[channel[0]], frame.inputs[channel[1]], frame.inputs[channel[2]], frame.inputs[channel[3]]), c);
+			changing |= simd::movemask(simd::float_4::cast(~(channel == selectedChannels[c / 4]))) << c;
+			selectedChannels[c / 4] = channel;
+		}
+
+		const auto triggered = changing & ~changingChannels & usedChannels;
+		changingChannels = (changing & usedChannels) | ~usedChannels;
+
+		const auto pulseSamples = simd::int32_4(math::toSamples(1e-3f, args.sampleRate));
+		for (int c = 0; c < PORT_MAX_CHANNELS; c += 4)
+		{
+			// unused channels start over from the first input channel
+			const auto unused = math::laneMask(~usedChannels >> c);
+			selectedChannels[c / 4] = simd::ifelse(simd::int32_4::cast(unused), simd::int32_4::zero(), selectedChannels[c / 4]);
+
+			auto& pulseGenerator = pulseGenerators[c / 4];
+			pulseGenerator.reset(unused);
+			pulseGenerator.trigger(math::laneMask(triggered >> c), pulseSamples);
+
+			if (c < channels)
+				outputs[TRIGGER_OUTPUT].setVoltageSimd(pulseGenerator.process() & simd::float_4(10.0f), c);
 		}
 	}
 
@@ -585,3 +909,4 @@ struct UT_OX : UT_Base
 
 Model* modelUtp = DigitalAtavism::createDaModel<DigitalAtavism::UT_P>("UT-P");
 Model* modelUtox = DigitalAtavism::createDaModel<DigitalAtavism::UT_OX>("UT-OX");
+Model* modelUtb = DigitalAtavism::createDaModel<DigitalAtavism::UT_B>("UT-B");
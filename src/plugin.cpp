@@ -13,8 +13,10 @@ void init(Plugin* p) {
 	p->addModel(modelCoin);
 	p->addModel(modelDTrig);
 	p->addModel(modelHit);
+	p->addModel(modelHR);
 	p->addModel(modelUtp);
 	p->addModel(modelUtox);
+	p->addModel(modelUtb);
 
 	// Any other plugin initialization may go here.
 	// As an alternative, consider lazy-loading assets and lookup tables when your module is created to reduce startup times of Rack.
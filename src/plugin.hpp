@@ -14,5 +14,7 @@ extern Model* modelBlip;
 extern Model* modelCoin;
 extern Model* modelDTrig;
 extern Model* modelHit;
+extern Model* modelHR;
 extern Model* modelUtp;
 extern Model* modelUtox;
+extern Model* modelUtb;
@@ -0,0 +1,135 @@
+// Standalone checks of the sample-exact timing helpers in DA.hpp: durations converted to samples at the common
+// engine rates, the tick timers built on them, and the sub-sample position of a trigger's edge.
+// Built and run by `make test`.
+#include "DA.hpp"
+#include <cstdio>
+#include <cmath>
+
+Plugin* pluginInstance;
+
+namespace da = DigitalAtavism;
+
+static int failures = 0;
+
+static void check(bool passed, const char* what, float sampleRate, float duration, long actual, long expected)
+{
+	if (!passed)
+	{
+		std::printf("FAIL %s at %g Hz, %g s: %ld, expected %ld\n", what, sampleRate, duration, actual, expected);
+		++failures;
+	}
+}
+
+// the samples a timer takes for duration, counting the sample it is triggered in as the first
+static void testTimers(float sampleRate, float duration, int expected)
+{
+	const auto samples = da::math::toSamples(duration, sampleRate);
+	check(samples == expected, "toSamples", sampleRate, duration, samples, expected);
+
+	const auto lanes = da::math::toSamples(simd::float_4(duration), sampleRate);
+	for (int i = 0; i < 4; ++i)
+		check(lanes[i] == expected, "toSamples (SIMD)", sampleRate, duration, lanes[i], expected);
+
+	// lane i is triggered with i samples less, to tell the lanes apart
+	const auto lengths = lanes - simd::int32_4(0, 1, 2, 3);
+
+	da::dsp::TTickTrigger<simd::float_4> trigger;
+	trigger.trigger(simd::float_4::mask(), lengths);
+
+	da::dsp::TTickPulseGenerator<simd::float_4> pulse;
+	pulse.trigger(simd::float_4::mask(), lengths);
+
+	long fired[4] = { -1, -1, -1, -1 };
+	long high[4] = {};
+	for (long n = 1; n <= expected + 16; ++n)
+	{
+		const auto firing = simd::movemask(trigger.process());
+		const auto pulsing = simd::movemask(pulse.process());
+		for (int i = 0; i < 4; ++i)
+		{
+			if (firing & (1 << i))
+			{
+				check(fired[i] < 0, "TTickTrigger fired twice", sampleRate, duration, n, fired[i]);
+				fired[i] = n;
+			}
+
+			high[i] += (pulsing >> i) & 1;
+		}
+	}
+
+	for (int i = 0; i < 4; ++i)
+	{
+		check(fired[i] == lengths[i], "TTickTrigger", sampleRate, duration, fired[i], lengths[i]);
+		check(high[i] == lengths[i], "TTickPulseGenerator", sampleRate, duration, high[i], lengths[i]);
+	}
+}
+
+// a step from `from` to `to` volts, scaled the way the modules scale their trigger inputs, should cross 2V elapsed
+// samples before the sample it arrives in
+static void testSubSampleTrigger(float from, float to, float elapsed)
+{
+	da::dsp::TSubSampleTrigger<simd::float_4> trigger;
+
+	const auto scale = [](float voltage) { return simd::float_4((voltage - 0.1f) / (2.f - 0.1f)); };
+	trigger.process(scale(from));
+
+	// only lane 2 steps up
+	const auto input = simd::ifelse(simd::float_4::cast(simd::int32_4(0, 0, -1, 0)), scale(to), scale(from));
+	const auto triggered = simd::movemask(trigger.process(input));
+	if (triggered != 1 << 2)
+	{
+		std::printf("FAIL TSubSampleTrigger from %g V to %g V: lanes %x triggered, expected 4\n", from, to, triggered);
+		++failures;
+	}
+
+	for (int i = 0; i < 4; ++i)
+	{
+		const auto expected = i == 2 ? elapsed : 0.f;
+		if (std::fabs(trigger.elapsed[i] - expected) > 1e-5f)
+		{
+			std::printf("FAIL TSubSampleTrigger from %g V to %g V: lane %d elapsed %g, expected %g\n", from, to, i, trigger.elapsed[i], expected);
+			++failures;
+		}
+	}
+
+	// holding the level doesn't trigger again
+	if (simd::movemask(trigger.process(input)) || simd::movemask(trigger.elapsed != 0.f))
+	{
+		std::printf("FAIL TSubSampleTrigger from %g V to %g V: retriggered while held\n", from, to);
+		++failures;
+	}
+}
+
+int main()
+{
+	const float sampleRates[] = { 44100.f, 48000.f, 96000.f, 192000.f };
+	const float durations[] = { 0.001f, 0.01f, 0.25f };
+	const int expected[][3] = {
+		{ 44, 441, 11025 },
+		{ 48, 480, 12000 },
+		{ 96, 960, 24000 },
+		{ 192, 1920, 48000 },
+	};
+
+	for (int r = 0; r < 4; ++r)
+		for (int d = 0; d < 3; ++d)
+			testTimers(sampleRates[r], durations[d], expected[r][d]);
+
+	// zero never fires, and any positive duration lasts at least one sample
+	for (auto sampleRate : sampleRates)
+	{
+		check(da::math::toSamples(0.f, sampleRate) == 0, "toSamples", sampleRate, 0.f, da::math::toSamples(0.f, sampleRate), 0);
+		check(da::math::toSamples(1e-9f, sampleRate) == 1, "toSamples", sampleRate, 1e-9f, da::math::toSamples(1e-9f, sampleRate), 1);
+	}
+
+	testSubSampleTrigger(0.f, 4.f, 0.5f);
+	testSubSampleTrigger(0.f, 2.f, 0.f);
+	testSubSampleTrigger(0.f, 10.f, 0.8f);
+
+	if (failures)
+		std::printf("%d timing checks failed\n", failures);
+	else
+		std::printf("timing checks passed\n");
+
+	return failures ? 1 : 0;
+}